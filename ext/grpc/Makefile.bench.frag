@@ -0,0 +1,5 @@
+
+bench: all
+	$(PHP_EXECUTABLE) -n -d extension_dir=$(top_builddir)/modules \
+	  -d extension=grpc.so \
+	  $(top_srcdir)/../../tests/benchmark/conversions.php $(BENCH_ARGS)
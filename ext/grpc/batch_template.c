@@ -0,0 +1,273 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "batch_template.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include <ext/spl/spl_exceptions.h>
+#include "php_grpc.h"
+
+#include <zend_exceptions.h>
+
+#include <stdbool.h>
+
+#include <grpc/grpc.h>
+
+#include "byte_buffer.h"
+#include "call.h"
+
+zend_class_entry *grpc_ce_batch_template;
+
+static zend_object_handlers batch_template_object_handlers_batch_template;
+
+/* Frees and destroys an instance of wrapped_grpc_batch_template */
+static void free_wrapped_grpc_batch_template(zend_object *object) {
+  wrapped_grpc_batch_template *template =
+    wrapped_grpc_batch_template_from_obj(object);
+  zend_object_std_dtor(&template->std);
+}
+
+/* Initializes an instance of wrapped_grpc_batch_template to be associated
+ * with an object of a class specified by class_type */
+zend_object *create_wrapped_grpc_batch_template(zend_class_entry *class_type) {
+  wrapped_grpc_batch_template *intern;
+  intern = ecalloc(1, sizeof(wrapped_grpc_batch_template) +
+                   zend_object_properties_size(class_type));
+
+  zend_object_std_init(&intern->std, class_type);
+  object_properties_init(&intern->std, class_type);
+
+  intern->std.handlers = &batch_template_object_handlers_batch_template;
+
+  return &intern->std;
+}
+
+/* Returns the number of values execute() takes for an op */
+static int op_value_count(grpc_op_type op) {
+  switch (op) {
+    case GRPC_OP_SEND_INITIAL_METADATA:
+    case GRPC_OP_SEND_MESSAGE:
+      return 1;
+    case GRPC_OP_SEND_STATUS_FROM_SERVER:
+      /* code, details and trailing metadata */
+      return 3;
+    default:
+      return 0;
+  }
+}
+
+/**
+ * Constructs a new instance of the BatchTemplate class. The ops are checked
+ * once here, so that execute() only has to fill in the values that change
+ * from one call to the next.
+ * @param array $ops The OP_* constants of the batch, each at most once
+ * @param long $flags The write flags of OP_SEND_MESSAGE (optional)
+ */
+PHP_METHOD(BatchTemplate, __construct) {
+  wrapped_grpc_batch_template *template =
+    Z_WRAPPED_GRPC_BATCH_TEMPLATE_P(getThis());
+  zval *ops_array;
+  zend_long flags = 0;
+  zval *value;
+  unsigned int seen = 0;
+
+  /* "a|l" == 1 array, 1 optional long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a|l", &ops_array,
+                            &flags) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "BatchTemplate expects an array and an optional "
+                         "long", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ARRAY(ops_array)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG(flags)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  template->op_num = 0;
+  template->value_count = 0;
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(ops_array), value) {
+    if (Z_TYPE_P(value) != IS_LONG || Z_LVAL_P(value) < 0 ||
+        Z_LVAL_P(value) >= GRPC_PHP_MAX_BATCH_OPS) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "Unrecognized op in batch template", 1);
+      return;
+    }
+    if (seen & (1u << Z_LVAL_P(value))) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "Duplicate op in batch template", 1);
+      return;
+    }
+    seen |= 1u << Z_LVAL_P(value);
+    template->ops[template->op_num++] = (grpc_op_type)Z_LVAL_P(value);
+    template->value_count += op_value_count((grpc_op_type)Z_LVAL_P(value));
+  } ZEND_HASH_FOREACH_END();
+  template->flags = (uint32_t)flags & GRPC_WRITE_USED_MASK;
+}
+
+/**
+ * Start the batch on a call and wait for it to complete. The values are
+ * consumed in the order of the ops of the template:
+ *  - OP_SEND_INITIAL_METADATA takes the metadata array
+ *  - OP_SEND_MESSAGE takes the message string
+ *  - OP_SEND_STATUS_FROM_SERVER takes the status code, the status details
+ *    and the trailing metadata array
+ * @param Call $call The call to start the batch on
+ * @param mixed ...$values The values of the send ops
+ * @return object Object with results of all actions, as from startBatch
+ */
+PHP_METHOD(BatchTemplate, execute) {
+  wrapped_grpc_batch_template *template =
+    Z_WRAPPED_GRPC_BATCH_TEMPLATE_P(getThis());
+  zval *call_obj;
+  zval *values = NULL;
+  int value_count = 0;
+  int next = 0;
+  grpc_php_batch batch;
+  grpc_op *op;
+  size_t i;
+
+  grpc_php_batch_init(&batch);
+  object_init(return_value);
+
+  /* "O*" == 1 Object, any number of values */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O*", &call_obj, grpc_ce_call,
+                            &values, &value_count) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "execute expects a Call and the values of the batch",
+                         1);
+    goto cleanup;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, -1)
+    Z_PARAM_OBJECT_OF_CLASS(call_obj, grpc_ce_call)
+    Z_PARAM_VARIADIC('*', values, value_count)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (value_count != template->value_count) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Wrong number of values for the batch template", 1);
+    goto cleanup;
+  }
+  grpc_php_batch_begin(Z_WRAPPED_GRPC_CALL_P(call_obj), &batch);
+
+  for (i = 0; i < template->op_num; i++) {
+    op = &batch.ops[batch.op_num];
+    switch (template->ops[i]) {
+      case GRPC_OP_SEND_INITIAL_METADATA:
+        if (!create_metadata_array(&values[next++], &batch.metadata)) {
+          zend_throw_exception(spl_ce_InvalidArgumentException,
+                               "Bad metadata value given", 1);
+          goto cleanup;
+        }
+        op->data.send_initial_metadata.count = batch.metadata.count;
+        op->data.send_initial_metadata.metadata = batch.metadata.metadata;
+        break;
+      case GRPC_OP_SEND_MESSAGE:
+        if (Z_TYPE(values[next]) != IS_STRING) {
+          zend_throw_exception(spl_ce_InvalidArgumentException,
+                               "Expected a string for send message", 1);
+          goto cleanup;
+        }
+        op->flags = template->flags;
+        op->data.send_message = string_to_byte_buffer(
+            Z_STRVAL(values[next]), Z_STRLEN(values[next]));
+        next++;
+        break;
+      case GRPC_OP_SEND_STATUS_FROM_SERVER:
+        if (Z_TYPE(values[next]) != IS_LONG ||
+            Z_TYPE(values[next + 1]) != IS_STRING) {
+          zend_throw_exception(spl_ce_InvalidArgumentException,
+                               "Expected an integer status code and string "
+                               "status details", 1);
+          goto cleanup;
+        }
+        if (!create_metadata_array(&values[next + 2],
+                                   &batch.trailing_metadata)) {
+          zend_throw_exception(spl_ce_InvalidArgumentException,
+                               "Bad trailing metadata value given", 1);
+          goto cleanup;
+        }
+        op->data.send_status_from_server.status = Z_LVAL(values[next]);
+        op->data.send_status_from_server.status_details =
+            Z_STRVAL(values[next + 1]);
+        op->data.send_status_from_server.trailing_metadata =
+            batch.trailing_metadata.metadata;
+        op->data.send_status_from_server.trailing_metadata_count =
+            batch.trailing_metadata.count;
+        next += 3;
+        break;
+      default:
+        break;
+    }
+    op->op = template->ops[i];
+    batch.op_num++;
+  }
+
+  grpc_php_batch_run(Z_WRAPPED_GRPC_CALL_P(call_obj), &batch, return_value);
+
+cleanup:
+  grpc_php_batch_destroy(&batch);
+  RETURN_DESTROY_ZVAL(return_value);
+}
+
+static zend_function_entry batch_template_methods[] = {
+  PHP_ME(BatchTemplate, __construct, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+  PHP_ME(BatchTemplate, execute, NULL, ZEND_ACC_PUBLIC)
+  PHP_FE_END
+};
+
+void grpc_init_batch_template() {
+  zend_class_entry ce;
+  INIT_CLASS_ENTRY(ce, "Grpc\\BatchTemplate", batch_template_methods);
+  ce.create_object = create_wrapped_grpc_batch_template;
+  grpc_ce_batch_template = zend_register_internal_class(&ce);
+  memcpy(&batch_template_object_handlers_batch_template,
+         zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+  batch_template_object_handlers_batch_template.offset =
+    XtOffsetOf(wrapped_grpc_batch_template, std);
+  batch_template_object_handlers_batch_template.free_obj =
+    free_wrapped_grpc_batch_template;
+}
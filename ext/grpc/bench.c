@@ -0,0 +1,332 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "bench.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include <ext/spl/spl_exceptions.h>
+#include "php_grpc.h"
+
+#include <zend_exceptions.h>
+
+#include <grpc/grpc.h>
+#include <grpc/support/alloc.h>
+#include <grpc/support/atm.h>
+#include <grpc/support/time.h>
+
+#include "byte_buffer.h"
+#include "call.h"
+#include "timeval.h"
+
+zend_class_entry *grpc_ce_bench;
+
+/* The allocations made by grpc core while a case runs. PHP allocations have
+ * no such hook, so only the PHP memory held by the output of a conversion
+ * is measured */
+static gpr_atm alloc_count;
+static gpr_atm alloc_bytes;
+static gpr_allocation_functions default_allocation_functions;
+
+static void *counting_malloc(size_t size) {
+  gpr_atm_no_barrier_fetch_add(&alloc_count, 1);
+  gpr_atm_no_barrier_fetch_add(&alloc_bytes, (gpr_atm)size);
+  return default_allocation_functions.malloc_fn(size);
+}
+
+static void *counting_realloc(void *ptr, size_t size) {
+  gpr_atm_no_barrier_fetch_add(&alloc_count, 1);
+  gpr_atm_no_barrier_fetch_add(&alloc_bytes, (gpr_atm)size);
+  return default_allocation_functions.realloc_fn(ptr, size);
+}
+
+static void counting_free(void *ptr) {
+  default_allocation_functions.free_fn(ptr);
+}
+
+/* The inputs of the cases, prepared before they are measured */
+typedef struct bench_input {
+  size_t size;
+  /* A string of size bytes */
+  zval payload;
+  /* Metadata as given to startBatch, with the payload as the value */
+  zval metadata;
+  /* A client batch sending the payload as its message */
+  zval batch;
+  /* Metadata as received, with the payload as the value */
+  grpc_metadata recv_entry;
+  grpc_metadata_array recv_metadata;
+  /* The payload as received */
+  grpc_byte_buffer *buffer;
+} bench_input;
+
+static void bench_input_init(bench_input *input, size_t size) {
+  zval values;
+  zval message;
+  input->size = size;
+  ZVAL_NEW_STR(&input->payload, zend_string_alloc(size, 0));
+  memset(Z_STRVAL(input->payload), 'a', size);
+  Z_STRVAL(input->payload)[size] = '\0';
+
+  array_init(&values);
+  add_next_index_zval(&values, &input->payload);
+  Z_ADDREF(input->payload);
+  array_init(&input->metadata);
+  add_assoc_zval(&input->metadata, "x-bench", &values);
+
+  array_init(&message);
+  add_assoc_zval(&message, "message", &input->payload);
+  Z_ADDREF(input->payload);
+  array_init(&input->batch);
+  array_init(&values);
+  add_index_zval(&input->batch, GRPC_OP_SEND_INITIAL_METADATA, &values);
+  add_index_zval(&input->batch, GRPC_OP_SEND_MESSAGE, &message);
+  add_index_bool(&input->batch, GRPC_OP_SEND_CLOSE_FROM_CLIENT, 1);
+  add_index_bool(&input->batch, GRPC_OP_RECV_INITIAL_METADATA, 1);
+  add_index_bool(&input->batch, GRPC_OP_RECV_MESSAGE, 1);
+  add_index_bool(&input->batch, GRPC_OP_RECV_STATUS_ON_CLIENT, 1);
+
+  memset(&input->recv_entry, 0, sizeof(grpc_metadata));
+  input->recv_entry.key = "x-bench";
+  input->recv_entry.value = Z_STRVAL(input->payload);
+  input->recv_entry.value_length = size;
+  grpc_metadata_array_init(&input->recv_metadata);
+  input->recv_metadata.metadata = &input->recv_entry;
+  input->recv_metadata.count = 1;
+
+  input->buffer = string_to_byte_buffer(Z_STRVAL(input->payload), size);
+}
+
+static void bench_input_destroy(bench_input *input) {
+  zval_ptr_dtor(&input->payload);
+  zval_ptr_dtor(&input->metadata);
+  zval_ptr_dtor(&input->batch);
+  grpc_byte_buffer_destroy(input->buffer);
+}
+
+/* A case runs one conversion, frees its output and returns the bytes of PHP
+ * memory the output held */
+typedef size_t (*bench_case)(bench_input *input);
+
+static size_t bench_create_metadata_array(bench_input *input) {
+  grpc_metadata_array metadata;
+  grpc_metadata_array_init(&metadata);
+  create_metadata_array(&input->metadata, &metadata);
+  grpc_metadata_array_destroy(&metadata);
+  return 0;
+}
+
+static size_t bench_parse_metadata_array(bench_input *input) {
+  size_t before = zend_memory_usage(0);
+  size_t held;
+  zval metadata;
+  grpc_parse_metadata_array(&input->recv_metadata, &metadata);
+  held = zend_memory_usage(0) - before;
+  zval_ptr_dtor(&metadata);
+  return held;
+}
+
+static size_t bench_string_to_byte_buffer(bench_input *input) {
+  grpc_byte_buffer *buffer =
+      string_to_byte_buffer(Z_STRVAL(input->payload), input->size);
+  grpc_byte_buffer_destroy(buffer);
+  return 0;
+}
+
+static size_t bench_byte_buffer_to_string(bench_input *input) {
+  size_t before = zend_memory_usage(0);
+  size_t held;
+  char *string;
+  size_t length;
+  byte_buffer_to_string(input->buffer, &string, &length);
+  held = zend_memory_usage(0) - before;
+  efree(string);
+  return held;
+}
+
+static size_t bench_start_batch_ops(bench_input *input) {
+  size_t before = zend_memory_usage(0);
+  size_t held;
+  grpc_php_batch batch;
+  grpc_php_batch_init(&batch);
+  grpc_php_batch_parse(&input->batch, &batch);
+  held = zend_memory_usage(0) - before;
+  grpc_php_batch_destroy(&batch);
+  return held;
+}
+
+static size_t bench_timeval(bench_input *input) {
+  size_t before = zend_memory_usage(0);
+  size_t held;
+  zval timeval;
+  grpc_php_wrap_timeval(gpr_now(GPR_CLOCK_REALTIME), &timeval);
+  held = zend_memory_usage(0) - before;
+  zval_ptr_dtor(&timeval);
+  return held;
+}
+
+static const struct {
+  const char *name;
+  bench_case run;
+} bench_cases[] = {
+  {"create_metadata_array", bench_create_metadata_array},
+  {"grpc_parse_metadata_array", bench_parse_metadata_array},
+  {"string_to_byte_buffer", bench_string_to_byte_buffer},
+  {"byte_buffer_to_string", bench_byte_buffer_to_string},
+  {"start_batch_ops", bench_start_batch_ops},
+  {"timeval", bench_timeval},
+};
+
+#define BENCH_CASES (sizeof(bench_cases) / sizeof(bench_cases[0]))
+
+/**
+ * Get the names of the benchmark cases
+ * @return array The names
+ */
+PHP_METHOD(Bench, cases) {
+  size_t i;
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  array_init_size(return_value, BENCH_CASES);
+  for (i = 0; i < BENCH_CASES; i++) {
+    add_next_index_string(return_value, bench_cases[i].name);
+  }
+}
+
+/**
+ * Run a conversion of the extension on a payload of the given size, the
+ * given number of times
+ * @param string $case The name of the case, one of Bench::cases()
+ * @param long $size The size of the payload in bytes
+ * @param long $iterations The number of times to run the conversion
+ * @return array ['ns_per_op' => float, 'allocs_per_op' => float,
+ *     'bytes_copied_per_op' => float], where allocations are those of grpc
+ *     core and bytes copied are those it allocates plus the PHP memory held
+ *     by the converted output
+ */
+PHP_METHOD(Bench, run) {
+  zend_string *name;
+  zend_long size;
+  zend_long iterations;
+  bench_case run = NULL;
+  bench_input input;
+  gpr_allocation_functions counting_functions;
+  gpr_timespec start;
+  gpr_timespec elapsed;
+  size_t held = 0;
+  zend_long i;
+
+  /* "Sll" == 1 string, 2 longs */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "Sll", &name, &size,
+                            &iterations) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "run expects a case, a size and a number of "
+                         "iterations", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(3, 3)
+    Z_PARAM_STR(name)
+    Z_PARAM_LONG(size)
+    Z_PARAM_LONG(iterations)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  for (i = 0; i < (zend_long)BENCH_CASES; i++) {
+    if (strcmp(bench_cases[i].name, ZSTR_VAL(name)) == 0) {
+      run = bench_cases[i].run;
+    }
+  }
+  if (run == NULL) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Unknown benchmark case", 1);
+    return;
+  }
+  if (size < 0 || iterations <= 0) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "The size must not be negative and the number of "
+                         "iterations must be positive", 1);
+    return;
+  }
+
+  bench_input_init(&input, (size_t)size);
+  /* Warm up the allocators */
+  run(&input);
+
+  default_allocation_functions = gpr_get_allocation_functions();
+  counting_functions = default_allocation_functions;
+  counting_functions.malloc_fn = counting_malloc;
+  counting_functions.realloc_fn = counting_realloc;
+  counting_functions.free_fn = counting_free;
+  gpr_atm_no_barrier_store(&alloc_count, 0);
+  gpr_atm_no_barrier_store(&alloc_bytes, 0);
+  gpr_set_allocation_functions(counting_functions);
+
+  start = gpr_now(GPR_CLOCK_MONOTONIC);
+  for (i = 0; i < iterations; i++) {
+    held += run(&input);
+  }
+  elapsed = gpr_time_sub(gpr_now(GPR_CLOCK_MONOTONIC), start);
+
+  gpr_set_allocation_functions(default_allocation_functions);
+  bench_input_destroy(&input);
+
+  array_init_size(return_value, 3);
+  add_assoc_double(return_value, "ns_per_op",
+                   ((double)elapsed.tv_sec * GPR_NS_PER_SEC + elapsed.tv_nsec) /
+                   iterations);
+  add_assoc_double(return_value, "allocs_per_op",
+                   (double)gpr_atm_no_barrier_load(&alloc_count) / iterations);
+  add_assoc_double(return_value, "bytes_copied_per_op",
+                   ((double)gpr_atm_no_barrier_load(&alloc_bytes) + held) /
+                   iterations);
+}
+
+static zend_function_entry bench_methods[] = {
+  PHP_ME(Bench, cases, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(Bench, run, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_FE_END
+};
+
+void grpc_init_bench() {
+  zend_class_entry ce;
+  INIT_CLASS_ENTRY(ce, "Grpc\\Bench", bench_methods);
+  grpc_ce_bench = zend_register_internal_class(&ce);
+}
@@ -44,12 +44,14 @@
 #include <string.h>
 
 #include "byte_buffer.h"
+#include "probes.h"
 
 #include <grpc/grpc.h>
 #include <grpc/byte_buffer_reader.h>
 #include <grpc/support/slice.h>
 
 grpc_byte_buffer *string_to_byte_buffer(char *string, size_t length) {
+  GRPC_PHP_PROBE1(byte__buffer__write, length);
   gpr_slice slice = gpr_slice_from_copied_buffer(string, length);
   grpc_byte_buffer *buffer = grpc_raw_byte_buffer_create(&slice, 1);
   gpr_slice_unref(slice);
@@ -71,6 +73,7 @@ void byte_buffer_to_string(grpc_byte_buffer *buffer, char **out_string,
   memcpy(string, GPR_SLICE_START_PTR(slice), length);
   gpr_slice_unref(slice);
 
+  GRPC_PHP_PROBE1(byte__buffer__read, length);
   *out_string = string;
   *out_length = length;
 }
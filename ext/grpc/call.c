@@ -50,23 +50,135 @@
 #include <stdbool.h>
 
 #include <grpc/support/alloc.h>
+#include <grpc/support/time.h>
 #include <grpc/grpc.h>
 
 #include "completion_queue.h"
 #include "timeval.h"
 #include "channel.h"
+#include "channel_pool.h"
 #include "byte_buffer.h"
+#include "metrics.h"
+#include "probes.h"
+#include "slow_call_log.h"
+#include "stats.h"
 
 zend_class_entry *grpc_ce_call;
 
 static zend_object_handlers call_object_handlers_call;
 
+/* Milliseconds between the checks for an aborted request while waiting for
+ * a batch to complete */
+#define GRPC_PHP_ABORT_CHECK_MS 100
+
+/* Adds a call to the calls of the request */
+static void track_call(wrapped_grpc_call *call) {
+  call->prev_live = NULL;
+  call->next_live = GRPC_G(live_calls);
+  if (call->next_live != NULL) {
+    call->next_live->prev_live = call;
+  }
+  GRPC_G(live_calls) = call;
+  call->live = true;
+}
+
+/* Removes a call from the calls of the request */
+static void untrack_call(wrapped_grpc_call *call) {
+  if (!call->live) {
+    return;
+  }
+  if (call->prev_live != NULL) {
+    call->prev_live->next_live = call->next_live;
+  } else {
+    GRPC_G(live_calls) = call->next_live;
+  }
+  if (call->next_live != NULL) {
+    call->next_live->prev_live = call->prev_live;
+  }
+  call->prev_live = NULL;
+  call->next_live = NULL;
+  call->live = false;
+}
+
+/* Cancels the calls of the request. Calls that have already completed are
+ * not affected */
+static void cancel_live_calls() {
+  wrapped_grpc_call *call;
+  while ((call = GRPC_G(live_calls)) != NULL) {
+    grpc_call_cancel(call->wrapped, NULL);
+    untrack_call(call);
+  }
+}
+
+/* Returns whether the request timed out, or was aborted by the client while
+ * user aborts are not ignored */
+static bool request_aborted() {
+#if PHP_VERSION_ID >= 70100
+  if (EG(timed_out)) {
+    return true;
+  }
+#endif
+  if (PG(connection_status) & PHP_CONNECTION_TIMEOUT) {
+    return true;
+  }
+  return (PG(connection_status) & PHP_CONNECTION_ABORTED) &&
+      !PG(ignore_user_abort);
+}
+
+/* Waits for the batch started on a call to complete. If the request is
+ * aborted meanwhile, the call and the other calls of the request are
+ * cancelled, so that the batch completes without waiting for the server */
+static void wait_for_batch(grpc_call *call) {
+  grpc_event event;
+  bool cancelled = false;
+  do {
+    event = grpc_completion_queue_pluck(
+        completion_queue, call,
+        gpr_time_add(gpr_now(GPR_CLOCK_MONOTONIC),
+                     gpr_time_from_millis(GRPC_PHP_ABORT_CHECK_MS,
+                                          GPR_TIMESPAN)),
+        NULL);
+    if (event.type == GRPC_QUEUE_TIMEOUT && !cancelled &&
+        request_aborted()) {
+      cancel_live_calls();
+      grpc_call_cancel(call, NULL);
+      cancelled = true;
+    }
+  } while (event.type == GRPC_QUEUE_TIMEOUT);
+}
+
+/* Removes a client call from its channel's calls in flight */
+void grpc_php_call_done(wrapped_grpc_call *call) {
+  if (call->in_flight) {
+    Z_WRAPPED_GRPC_CHANNEL_P(&call->channel)->in_flight--;
+    call->in_flight = false;
+  }
+}
+
 /* Frees and destroys an instance of wrapped_grpc_call */
 static void free_wrapped_grpc_call(zend_object *object) {
   wrapped_grpc_call *call = wrapped_grpc_call_from_obj(object);
+  untrack_call(call);
+  grpc_php_call_done(call);
+  if (call->pending_batch != NULL) {
+    /* The batch writes into its buffers until it completes */
+    grpc_call_cancel(call->wrapped, NULL);
+    wait_for_batch(call->wrapped);
+    grpc_php_batch_destroy(call->pending_batch);
+    efree(call->pending_batch);
+  }
   if (call->owned && call->wrapped != NULL) {
     grpc_call_destroy(call->wrapped);
   }
+  zval_ptr_dtor(&call->channel);
+  if (call->method != NULL) {
+    zend_string_release(call->method);
+  }
+  if (call->target != NULL) {
+    gpr_free(call->target);
+  }
+  zval_ptr_dtor(&call->deserializer_callable);
+  zval_ptr_dtor(&call->deserialize_into);
   zend_object_std_dtor(&call->std);
 }
 
@@ -81,6 +193,8 @@ zend_object *create_wrapped_grpc_call(zend_class_entry *class_type) {
   object_properties_init(&intern->std, class_type);
   
   intern->std.handlers = &call_object_handlers_call;
+  /* Slow calls are logged with their timings */
+  intern->timed = GRPC_G(call_timings) || grpc_php_slow_call_log_enabled();
   
   return &intern->std;
 }
@@ -92,6 +206,9 @@ void grpc_php_wrap_call(grpc_call *wrapped, bool owned, zval *call_object) {
   wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(call_object);
   call->wrapped = wrapped;
   call->owned = owned;
+  if (owned) {
+    track_call(call);
+  }
 }
 
 /* Creates and returns a PHP array object with the data in a
@@ -103,34 +220,28 @@ void grpc_parse_metadata_array(grpc_metadata_array *metadata_array, zval *array)
   zval *data;
   HashTable *array_hash;
   zval inner_array;
-  char *str_key;
-  char *str_val;
   size_t key_len;
   
+  GRPC_PHP_PROBE1(metadata__parse, count);
   array_init(array);
   array_hash = HASH_OF(array);
   grpc_metadata *elem;
   for (i = 0; i < count; i++) {
     elem = &elements[i];
     key_len = strlen(elem->key);
-    str_key = ecalloc(key_len + 1, sizeof(char));
-    memcpy(str_key, elem->key, key_len);
-    str_val = ecalloc(elem->value_length + 1, sizeof(char));
-    memcpy(str_val, elem->value, elem->value_length);
-    if ((data = zend_hash_str_find(array_hash, str_key, key_len)) != NULL) {
+    /* The strings are copied straight from the grpc buffers */
+    if ((data = zend_hash_str_find(array_hash, elem->key, key_len)) != NULL) {
       if (Z_TYPE_P(data) != IS_ARRAY) {
         zend_throw_exception(zend_exception_get_default(),
                              "Metadata hash somehow contains wrong types.",
                              1);
-        efree(str_key);
-        efree(str_val);
         return;
       }
-      add_next_index_stringl(data, str_val, elem->value_length);
+      add_next_index_stringl(data, elem->value, elem->value_length);
     } else {
       array_init(&inner_array);
-      add_next_index_stringl(&inner_array, str_val, elem->value_length);
-      add_assoc_zval(array, str_key, &inner_array);
+      add_next_index_stringl(&inner_array, elem->value, elem->value_length);
+      add_assoc_zval_ex(array, elem->key, key_len, &inner_array);
     }
   }
 }
@@ -203,70 +314,451 @@ bool create_metadata_array(zval *array, grpc_metadata_array *metadata) {
       metadata->count += 1;
     } ZEND_HASH_FOREACH_END();
   } ZEND_HASH_FOREACH_END();
+  GRPC_PHP_PROBE1(metadata__create, metadata->count);
+  return true;
+}
+
+/* Reads a call deadline given as a Timeval, as a timeout in microseconds or
+ * as null for no deadline. Throws and returns false otherwise */
+static bool read_deadline(zval *deadline_zval, gpr_timespec *deadline) {
+  /* A relative timeout is resolved against the monotonic clock, so that it
+   * is not affected by changes of the system time */
+  if (deadline_zval == NULL || Z_TYPE_P(deadline_zval) == IS_NULL) {
+    *deadline = gpr_inf_future(GPR_CLOCK_MONOTONIC);
+  } else if (Z_TYPE_P(deadline_zval) == IS_LONG) {
+    *deadline = gpr_time_add(
+        gpr_now(GPR_CLOCK_MONOTONIC),
+        gpr_time_from_micros(Z_LVAL_P(deadline_zval), GPR_TIMESPAN));
+  } else if (Z_TYPE_P(deadline_zval) == IS_OBJECT &&
+             instanceof_function(Z_OBJCE_P(deadline_zval),
+                                 grpc_ce_timeval)) {
+    *deadline = Z_WRAPPED_GRPC_TIMEVAL_P(deadline_zval)->wrapped;
+  } else {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Call expects a Timeval, a long or null deadline", 1);
+    return false;
+  }
+  return true;
+}
+
+/* Returns the channel a new call on a Channel or ChannelPool object should
+ * use, and points channel_obj to its Channel object. Throws and returns NULL
+ * if the object is neither or is closed */
+static wrapped_grpc_channel *resolve_call_channel(zval **channel_obj) {
+  wrapped_grpc_channel *channel;
+  if (instanceof_function(Z_OBJCE_P(*channel_obj), grpc_ce_channel_pool)) {
+    *channel_obj = grpc_php_channel_pool_pick(
+        Z_WRAPPED_GRPC_CHANNEL_POOL_P(*channel_obj));
+    if (*channel_obj == NULL) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "Call cannot be constructed from a closed "
+                           "ChannelPool", 1);
+      return NULL;
+    }
+  } else if (!instanceof_function(Z_OBJCE_P(*channel_obj), grpc_ce_channel)) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Call expects a Channel or a ChannelPool", 1);
+    return NULL;
+  }
+  channel = Z_WRAPPED_GRPC_CHANNEL_P(*channel_obj);
+  if (channel->wrapped == NULL) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Call cannot be constructed from a closed Channel",
+                         1);
+    return NULL;
+  }
+  return channel;
+}
+
+/* Returns whether a Call object wraps a call received by a server */
+static inline bool is_server_call(zval *call_obj) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(call_obj);
+  return Z_TYPE(call->channel) == IS_UNDEF && call->wrapped != NULL;
+}
+
+/* Points parent to the server call a new client call propagates from: the
+ * given Call object, else the server context of the request, else NULL.
+ * Throws and returns false if the given object is not a server call */
+static bool resolve_parent_call(zval *parent_obj, grpc_call **parent) {
+  *parent = NULL;
+  if (parent_obj == NULL) {
+    if (Z_TYPE(GRPC_G(server_context)) == IS_OBJECT) {
+      *parent = Z_WRAPPED_GRPC_CALL_P(&GRPC_G(server_context))->wrapped;
+    }
+    return true;
+  }
+  if (!is_server_call(parent_obj)) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "A parent call must be a call received by a server",
+                         1);
+    return false;
+  }
+  *parent = Z_WRAPPED_GRPC_CALL_P(parent_obj)->wrapped;
   return true;
 }
 
 /**
  * Constructs a new instance of the Call class.
- * @param Channel $channel The channel to associate the call with. Must not be
- *     closed.
+ * @param Channel|ChannelPool $channel The channel to associate the call with.
+ *     Must not be closed. For a ChannelPool, the channel of the pool with the
+ *     fewest calls in flight is used.
  * @param string $method The method to call
- * @param Timeval $absolute_deadline The deadline for completing the call
+ * @param Timeval|long|null $deadline The absolute deadline for completing the
+ *     call, a timeout in microseconds from now, or null for no deadline
+ * @param string $host_override The host to call on the channel (optional)
+ * @param Call $parent The server call to propagate the deadline and the
+ *     cancellation from (optional). Defaults to the server context set with
+ *     Call::setServerContext
+ * @param long $propagate The PROPAGATE_* mask of what to propagate from the
+ *     parent call (optional)
  */
 PHP_METHOD(Call, __construct) {
   wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
   zval *channel_obj;
   zend_string *method;
-  zval *deadline_obj;
-  zend_string *host_override;
+  zval *deadline_zval;
+  zend_string *host_override = NULL;
+  zval *parent_obj = NULL;
+  zend_long propagate = GRPC_PROPAGATE_DEFAULTS;
+  grpc_call *parent;
+  gpr_timespec deadline;
 
-  /* "OSO|S" == 1 Object, 1 string, 1 Object, 1 optional string */
+  /* "oSz|S!O!l" == 1 object, 1 string, 1 zval, 1 optional nullable string,
+   * 1 optional nullable Object, 1 optional long */
 #ifndef FAST_ZPP
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "OSO|S", &channel_obj,
-                            grpc_ce_channel, &method, &deadline_obj,
-                            grpc_ce_timeval, &host_override) == FAILURE) {
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "oSz|S!O!l", &channel_obj,
+                            &method, &deadline_zval, &host_override,
+                            &parent_obj, grpc_ce_call,
+                            &propagate) == FAILURE) {
     zend_throw_exception(
         spl_ce_InvalidArgumentException,
-        "Call expects a Channel, a String, a Timeval and an optional String",
-        1);
+        "Call expects a Channel, a String, a deadline and an optional String, "
+        "parent Call and propagation mask", 1);
     return;
   }
 #else
-  ZEND_PARSE_PARAMETERS_START(3, 4)
-    Z_PARAM_OBJECT_OF_CLASS(channel_obj, grpc_ce_channel)
+  ZEND_PARSE_PARAMETERS_START(3, 6)
+    Z_PARAM_OBJECT(channel_obj)
     Z_PARAM_STR(method)
-    Z_PARAM_OBJECT_OF_CLASS(deadline_obj, grpc_ce_timeval)
+    Z_PARAM_ZVAL(deadline_zval)
     Z_PARAM_OPTIONAL
-    Z_PARAM_STR(host_override)
+    Z_PARAM_STR_EX(host_override, 1, 0)
+    Z_PARAM_OBJECT_OF_CLASS_EX(parent_obj, grpc_ce_call, 1, 0)
+    Z_PARAM_LONG(propagate)
   ZEND_PARSE_PARAMETERS_END();
 #endif
 
-  wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(channel_obj);
-  if (channel->wrapped == NULL) {
-    zend_throw_exception(spl_ce_InvalidArgumentException,
-                         "Call cannot be constructed from a closed Channel",
-                         1);
+  if (!read_deadline(deadline_zval, &deadline)) {
+    return;
+  }
+  if (!resolve_parent_call(parent_obj, &parent)) {
+    return;
+  }
+  wrapped_grpc_channel *channel = resolve_call_channel(&channel_obj);
+  if (channel == NULL) {
     return;
   }
   add_property_zval(getThis(), "channel", channel_obj);
-  wrapped_grpc_timeval *deadline = Z_WRAPPED_GRPC_TIMEVAL_P(deadline_obj);
   call->wrapped = grpc_channel_create_call(
-      channel->wrapped, NULL, GRPC_PROPAGATE_DEFAULTS, completion_queue,
+      channel->wrapped, parent, (uint32_t)propagate, completion_queue,
       ZSTR_VAL(method), host_override == NULL ? NULL : ZSTR_VAL(host_override),
-      deadline->wrapped, NULL);
+      deadline, NULL);
   call->owned = true;
+  track_call(call);
+  ZVAL_COPY(&call->channel, channel_obj);
+  channel->in_flight++;
+  call->in_flight = true;
+  call->start_time = gpr_now(GPR_CLOCK_MONOTONIC);
+  call->method_stats = grpc_php_method_metrics_find(ZSTR_VAL(method),
+                                                    ZSTR_LEN(method));
+  call->method = zend_string_copy(method);
+  call->deadline = deadline;
+  if (grpc_php_slow_call_log_enabled()) {
+    call->target = grpc_channel_get_target(channel->wrapped);
+  }
+  GRPC_PHP_PROBE2(call__create, ZSTR_VAL(method), call->wrapped);
+  grpc_php_stats_call_started(&channel->stats, call->method_stats);
 }
 
-/**
- * Start a batch of RPC actions.
- * @param array batch Array of actions to take
- * @return object Object with results of all actions
- */
-PHP_METHOD(Call, startBatch) {
-  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
-  grpc_op ops[8];
-  size_t op_num = 0;
-  zval *array;
+void grpc_php_batch_init(grpc_php_batch *batch) {
+  memset(batch, 0, sizeof(grpc_php_batch));
+  grpc_metadata_array_init(&batch->metadata);
+  grpc_metadata_array_init(&batch->trailing_metadata);
+  grpc_metadata_array_init(&batch->recv_metadata);
+  grpc_metadata_array_init(&batch->recv_trailing_metadata);
+}
+
+void grpc_php_batch_destroy(grpc_php_batch *batch) {
+  size_t i;
+  grpc_metadata_array_destroy(&batch->metadata);
+  grpc_metadata_array_destroy(&batch->trailing_metadata);
+  grpc_metadata_array_destroy(&batch->recv_metadata);
+  grpc_metadata_array_destroy(&batch->recv_trailing_metadata);
+  if (batch->status_details != NULL) {
+    gpr_free(batch->status_details);
+  }
+  for (i = 0; i < batch->op_num; i++) {
+    if (batch->ops[i].op == GRPC_OP_SEND_MESSAGE) {
+      grpc_byte_buffer_destroy(batch->ops[i].data.send_message);
+    }
+  }
+  if (batch->message != NULL) {
+    grpc_byte_buffer_destroy(batch->message);
+  }
+}
+
+/* Returns the method of a client call, or NULL for a server call */
+static inline const char *call_method(wrapped_grpc_call *call) {
+  return call->method == NULL ? NULL : ZSTR_VAL(call->method);
+}
+
+/* Returns the counters of the channel of a client call, or NULL for a server
+ * call */
+static inline grpc_php_call_stats *call_stats(wrapped_grpc_call *call) {
+  if (Z_TYPE(call->channel) != IS_OBJECT) {
+    return NULL;
+  }
+  return &Z_WRAPPED_GRPC_CHANNEL_P(&call->channel)->stats;
+}
+
+/* Passes a received message to the deserializer of the call and sets
+ * message to the result, or to null if the deserializer threw */
+static void deserialize_message(wrapped_grpc_call *call, char *message_str,
+                                size_t message_len, zval *message) {
+  zend_fcall_info fci = call->deserializer;
+  zval callable;
+  zval arg;
+  zval retval;
+
+  /* The deserializer may replace itself while it runs */
+  ZVAL_COPY(&callable, &call->deserializer_callable);
+  ZVAL_STRINGL(&arg, message_str, message_len);
+  ZVAL_UNDEF(&retval);
+  fci.param_count = 1;
+  fci.params = &arg;
+  fci.retval = &retval;
+
+  ZVAL_NULL(message);
+  if (zend_call_function(&fci, &call->deserializer_cache) == SUCCESS &&
+      EG(exception) == NULL) {
+    if (Z_TYPE(call->deserialize_into) == IS_OBJECT) {
+      ZVAL_COPY(message, &call->deserialize_into);
+    } else if (Z_TYPE(retval) != IS_UNDEF) {
+      ZVAL_COPY(message, &retval);
+    }
+  }
+  zval_ptr_dtor(&retval);
+  zval_ptr_dtor(&arg);
+  zval_ptr_dtor(&callable);
+}
+
+/* Returns the nanoseconds from start to end */
+static inline int64_t elapsed_ns(gpr_timespec start, gpr_timespec end) {
+  gpr_timespec diff = gpr_time_sub(end, start);
+  return (int64_t)diff.tv_sec * GPR_NS_PER_SEC + diff.tv_nsec;
+}
+
+/* Adds the phases of a batch of a timed call to the totals of the call and
+ * to the timings property of the result */
+static void add_batch_timings(wrapped_grpc_call *call, grpc_php_batch *batch,
+                              gpr_timespec completed, zval *result) {
+  gpr_timespec converted = gpr_now(GPR_CLOCK_MONOTONIC);
+  int64_t build_ns = batch->build_start.tv_sec == 0 &&
+      batch->build_start.tv_nsec == 0 ?
+      0 : elapsed_ns(batch->build_start, batch->started);
+  int64_t wait_ns = elapsed_ns(batch->started, completed);
+  int64_t convert_ns = elapsed_ns(completed, converted);
+  zval timings;
+
+  call->timings.batches++;
+  call->timings.build_ns += build_ns;
+  call->timings.wait_ns += wait_ns;
+  call->timings.convert_ns += convert_ns;
+
+  array_init_size(&timings, 3);
+  add_assoc_long(&timings, "build_ns", (zend_long)build_ns);
+  add_assoc_long(&timings, "wait_ns", (zend_long)wait_ns);
+  add_assoc_long(&timings, "convert_ns", (zend_long)convert_ns);
+  add_property_zval(result, "timings", &timings);
+  zval_ptr_dtor(&timings);
+}
+
+/* Points the receiving ops of a batch at its buffers and starts it on the
+ * call. Throws and returns false if the batch could not be started */
+static bool batch_start(wrapped_grpc_call *call, grpc_php_batch *batch) {
+  grpc_call_error error;
+  size_t i;
+
+  /* Completions are plucked by call, so only one batch can be waited for */
+  if (call->pending_batch != NULL) {
+    zend_throw_exception(spl_ce_LogicException,
+                         "a batch started by startBatchAsync has not been "
+                         "finished yet", 1);
+    return false;
+  }
+
+  /* The receiving ops all write to the buffers of the batch */
+  for (i = 0; i < batch->op_num; i++) {
+    grpc_op *op = &batch->ops[i];
+    switch (op->op) {
+      case GRPC_OP_RECV_INITIAL_METADATA:
+        op->data.recv_initial_metadata = &batch->recv_metadata;
+        break;
+      case GRPC_OP_RECV_MESSAGE:
+        op->data.recv_message = &batch->message;
+        break;
+      case GRPC_OP_RECV_STATUS_ON_CLIENT:
+        op->data.recv_status_on_client.trailing_metadata =
+            &batch->recv_trailing_metadata;
+        op->data.recv_status_on_client.status = &batch->status;
+        op->data.recv_status_on_client.status_details =
+            &batch->status_details;
+        op->data.recv_status_on_client.status_details_capacity =
+            &batch->status_details_capacity;
+        break;
+      case GRPC_OP_RECV_CLOSE_ON_SERVER:
+        op->data.recv_close_on_server.cancelled = &batch->cancelled;
+        break;
+      default:
+        break;
+    }
+  }
+
+  if (call->timed) {
+    batch->started = gpr_now(GPR_CLOCK_MONOTONIC);
+  }
+  GRPC_PHP_PROBE3(batch__start, call_method(call), call->wrapped,
+                  batch->op_num);
+  error = grpc_call_start_batch(call->wrapped, batch->ops, batch->op_num,
+                                call->wrapped, NULL);
+  if (error != GRPC_CALL_OK) {
+    zend_throw_exception(spl_ce_LogicException,
+                         "start_batch was called incorrectly",
+                         (long)error);
+    return false;
+  }
+  return true;
+}
+
+/* Waits for a started batch to complete and adds its results to the result
+ * object */
+static void batch_finish(wrapped_grpc_call *call, grpc_php_batch *batch,
+                         zval *result) {
+  gpr_timespec completed = gpr_time_0(GPR_CLOCK_MONOTONIC);
+  char *message_str;
+  size_t message_len;
+  zval message;
+  zval recv_status;
+  grpc_php_call_stats *stats = call_stats(call);
+  bool finished = false;
+  zval array;
+  size_t i;
+
+  wait_for_batch(call->wrapped);
+  GRPC_PHP_PROBE3(batch__done, call_method(call), call->wrapped,
+                  batch->op_num);
+  if (call->timed) {
+    completed = gpr_now(GPR_CLOCK_MONOTONIC);
+  }
+
+  for (i = 0; i < batch->op_num; i++) {
+    switch(batch->ops[i].op) {
+      case GRPC_OP_SEND_INITIAL_METADATA:
+        add_property_bool(result, "send_metadata", true);
+        break;
+      case GRPC_OP_SEND_MESSAGE:
+        add_property_bool(result, "send_message", true);
+        if (stats != NULL) {
+          message_len =
+              grpc_byte_buffer_length(batch->ops[i].data.send_message);
+          grpc_php_stats_add_bytes(stats, call->method_stats, message_len, 0);
+          call->bytes_sent += message_len;
+        }
+        break;
+      case GRPC_OP_SEND_CLOSE_FROM_CLIENT:
+        add_property_bool(result, "send_close", true);
+        break;
+      case GRPC_OP_SEND_STATUS_FROM_SERVER:
+        add_property_bool(result, "send_status", true);
+        break;
+      case GRPC_OP_RECV_INITIAL_METADATA:
+        grpc_parse_metadata_array(&batch->recv_metadata, &array);
+        add_property_zval(result, "metadata", &array);
+        zval_ptr_dtor(&array);
+        break;
+      case GRPC_OP_RECV_MESSAGE:
+        byte_buffer_to_string(batch->message, &message_str, &message_len);
+        if (message_str != NULL && stats != NULL) {
+          grpc_php_stats_add_bytes(stats, call->method_stats, 0,
+                                   message_len);
+          call->bytes_received += message_len;
+        }
+        if (message_str == NULL) {
+          add_property_null(result, "message");
+        } else if (call->has_deserializer) {
+          deserialize_message(call, message_str, message_len, &message);
+          add_property_zval(result, "message", &message);
+          zval_ptr_dtor(&message);
+          efree(message_str);
+        } else {
+          add_property_stringl(result, "message", message_str, message_len);
+          efree(message_str);
+        }
+        break;
+      case GRPC_OP_RECV_STATUS_ON_CLIENT:
+        object_init(&recv_status);
+        grpc_parse_metadata_array(&batch->recv_trailing_metadata, &array);
+        add_property_zval(&recv_status, "metadata", &array);
+        zval_ptr_dtor(&array);
+        add_property_long(&recv_status, "code", batch->status);
+        add_property_string(&recv_status, "details",
+                            batch->status_details == NULL ?
+                            "" : batch->status_details);
+        add_property_zval(result, "status", &recv_status);
+        zval_ptr_dtor(&recv_status);
+        if (stats != NULL) {
+          grpc_php_stats_call_finished(stats, call->method_stats,
+                                       batch->status, call->start_time);
+          finished = true;
+        }
+        GRPC_PHP_PROBE5(call__finish, call_method(call), call->wrapped,
+                        batch->status, call->bytes_sent,
+                        call->bytes_received);
+        grpc_php_call_done(call);
+        break;
+      case GRPC_OP_RECV_CLOSE_ON_SERVER:
+        add_property_bool(result, "cancelled", batch->cancelled);
+        break;
+      default:
+        break;
+    }
+  }
+  if (call->timed) {
+    add_batch_timings(call, batch, completed, result);
+  }
+  if (finished && grpc_php_slow_call_log_enabled()) {
+    grpc_php_slow_call slow_call = {
+      ZSTR_VAL(call->method), ZSTR_LEN(call->method), call->target,
+      call->wrapped,
+      batch->status, call->bytes_sent, call->bytes_received,
+      call->start_time, call->deadline,
+      call->timed ? &call->timings : NULL
+    };
+    grpc_php_log_slow_call(&slow_call);
+  }
+}
+
+bool grpc_php_batch_run(wrapped_grpc_call *call, grpc_php_batch *batch,
+                        zval *result) {
+  if (!batch_start(call, batch)) {
+    return false;
+  }
+  batch_finish(call, batch, result);
+  return true;
+}
+
+bool grpc_php_batch_parse(zval *array, grpc_php_batch *batch) {
+  grpc_op *op;
   zval *value;
   zval *inner_value;
   HashTable *array_hash;
@@ -277,40 +769,6 @@ PHP_METHOD(Call, startBatch) {
   zval *message_flags;
   zend_string *key;
   zend_ulong index;
-  
-  grpc_metadata_array metadata;
-  grpc_metadata_array trailing_metadata;
-  grpc_metadata_array recv_metadata;
-  grpc_metadata_array recv_trailing_metadata;
-  grpc_status_code status;
-  char *status_details = NULL;
-  size_t status_details_capacity = 0;
-  grpc_byte_buffer *message;
-  int cancelled;
-  grpc_call_error error;
-  char *message_str;
-  size_t message_len;
-  zval recv_status;
-  
-  grpc_metadata_array_init(&metadata);
-  grpc_metadata_array_init(&trailing_metadata);
-  grpc_metadata_array_init(&recv_metadata);
-  grpc_metadata_array_init(&recv_trailing_metadata);
-  object_init(return_value);
-  memset(ops, 0, sizeof(ops));
-
-  /* "a" == 1 array */
-#ifndef FAST_ZPP
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &array) == FAILURE) {
-    zend_throw_exception(spl_ce_InvalidArgumentException,
-                         "start_batch expects an array", 1);
-    goto cleanup;
-  }
-#else
-  ZEND_PARSE_PARAMETERS_START(1, 1)
-    Z_PARAM_ARRAY(array)
-  ZEND_PARSE_PARAMETERS_END();
-#endif
 
   array_hash = HASH_OF(array);
   ZEND_HASH_FOREACH_KEY_VAL(array_hash, index, key, value) {
@@ -322,29 +780,35 @@ PHP_METHOD(Call, startBatch) {
                                      &array_pointer) != HASH_KEY_IS_LONG) {
       zend_throw_exception(spl_ce_InvalidArgumentException,
                            "batch keys must be integers", 1);
-      goto cleanup;
+      return false;
     }*/
     if (key) {
       zend_throw_exception(spl_ce_InvalidArgumentException,
                               "batch keys must be integers", 1);
-      goto cleanup;
+      return false;
+    }
+    if (batch->op_num == GRPC_PHP_MAX_BATCH_OPS) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "Too many ops in batch", 1);
+      return false;
     }
 
+    op = &batch->ops[batch->op_num];
     switch(index) {
       case GRPC_OP_SEND_INITIAL_METADATA:
-        if (!create_metadata_array(value, &metadata)) {
+        if (!create_metadata_array(value, &batch->metadata)) {
           zend_throw_exception(spl_ce_InvalidArgumentException,
                                "Bad metadata value given", 1);
-          goto cleanup;
+          return false;
         }
-        ops[op_num].data.send_initial_metadata.count = metadata.count;
-        ops[op_num].data.send_initial_metadata.metadata = metadata.metadata;
+        op->data.send_initial_metadata.count = batch->metadata.count;
+        op->data.send_initial_metadata.metadata = batch->metadata.metadata;
         break;
       case GRPC_OP_SEND_MESSAGE:
         if (Z_TYPE_P(value) != IS_ARRAY) {
           zend_throw_exception(spl_ce_InvalidArgumentException,
                                "Expected an array for send message", 1);
-          goto cleanup;
+          return false;
         }
         message_hash = HASH_OF(value);
         if ((message_flags = zend_hash_str_find(message_hash, "flags",
@@ -352,17 +816,18 @@ PHP_METHOD(Call, startBatch) {
           if (Z_TYPE_P(message_flags) != IS_LONG) {
             zend_throw_exception(spl_ce_InvalidArgumentException,
                                  "Expected an int for message flags", 1);
+            return false;
           }
-          ops[op_num].flags = Z_LVAL_P(message_flags) & GRPC_WRITE_USED_MASK;
+          op->flags = Z_LVAL_P(message_flags) & GRPC_WRITE_USED_MASK;
         }
         if ((message_value = zend_hash_str_find(
             message_hash, "message", sizeof("message") - 1)) == NULL ||
             Z_TYPE_P(message_value) != IS_STRING) {
           zend_throw_exception(spl_ce_InvalidArgumentException,
                                "Expected a string for send message", 1);
-          goto cleanup;
+          return false;
         }
-        ops[op_num].data.send_message =
+        op->data.send_message =
             string_to_byte_buffer(Z_STRVAL_P(message_value),
                                   Z_STRLEN_P(message_value));
         break;
@@ -372,157 +837,429 @@ PHP_METHOD(Call, startBatch) {
         status_hash = HASH_OF(value);
         if ((inner_value = zend_hash_str_find(
             status_hash, "metadata", sizeof("metadata") - 1)) != NULL) {
-          if (!create_metadata_array(inner_value, &trailing_metadata)) {
+          if (!create_metadata_array(inner_value, &batch->trailing_metadata)) {
             zend_throw_exception(spl_ce_InvalidArgumentException,
                                  "Bad trailing metadata value given", 1);
-            goto cleanup;
+            return false;
           }
-          ops[op_num].data.send_status_from_server.trailing_metadata =
-              trailing_metadata.metadata;
-          ops[op_num].data.send_status_from_server.trailing_metadata_count =
-              trailing_metadata.count;
+          op->data.send_status_from_server.trailing_metadata =
+              batch->trailing_metadata.metadata;
+          op->data.send_status_from_server.trailing_metadata_count =
+              batch->trailing_metadata.count;
         }
         if ((inner_value = zend_hash_str_find(
             status_hash, "code", sizeof("code") - 1)) != NULL) {
           if (Z_TYPE_P(inner_value) != IS_LONG) {
             zend_throw_exception(spl_ce_InvalidArgumentException,
                                  "Status code must be an integer", 1);
-            goto cleanup;
+            return false;
           }
-          ops[op_num].data.send_status_from_server.status =
-              Z_LVAL_P(inner_value);
+          op->data.send_status_from_server.status = Z_LVAL_P(inner_value);
         } else {
           zend_throw_exception(spl_ce_InvalidArgumentException,
                                "Integer status code is required", 1);
-          goto cleanup;
+          return false;
         }
         if ((inner_value = zend_hash_str_find(
             status_hash, "details", sizeof("details") - 1)) != NULL) {
           if (Z_TYPE_P(inner_value) != IS_STRING) {
             zend_throw_exception(spl_ce_InvalidArgumentException,
                                  "Status details must be a string", 1);
-            goto cleanup;
+            return false;
           }
-          ops[op_num].data.send_status_from_server.status_details =
+          op->data.send_status_from_server.status_details =
               Z_STRVAL_P(inner_value);
         } else {
           zend_throw_exception(spl_ce_InvalidArgumentException,
                                "String status details is required", 1);
-          goto cleanup;
+          return false;
         }
         break;
       case GRPC_OP_RECV_INITIAL_METADATA:
-        ops[op_num].data.recv_initial_metadata = &recv_metadata;
-        break;
       case GRPC_OP_RECV_MESSAGE:
-        ops[op_num].data.recv_message = &message;
-        break;
       case GRPC_OP_RECV_STATUS_ON_CLIENT:
-        ops[op_num].data.recv_status_on_client.trailing_metadata =
-            &recv_trailing_metadata;
-        ops[op_num].data.recv_status_on_client.status = &status;
-        ops[op_num].data.recv_status_on_client.status_details =
-            &status_details;
-        ops[op_num].data.recv_status_on_client.status_details_capacity =
-            &status_details_capacity;
-        break;
       case GRPC_OP_RECV_CLOSE_ON_SERVER:
-        ops[op_num].data.recv_close_on_server.cancelled = &cancelled;
         break;
       default:
         zend_throw_exception(spl_ce_InvalidArgumentException,
                              "Unrecognized key in batch", 1);
-        goto cleanup;
+        return false;
     }
-    ops[op_num].op = (grpc_op_type)index;
-    ops[op_num].flags = 0;
-    ops[op_num].reserved = NULL;
-    op_num++;
+    op->op = (grpc_op_type)index;
+    op->reserved = NULL;
+    batch->op_num++;
   }
   ZEND_HASH_FOREACH_END();
 
-  error = grpc_call_start_batch(call->wrapped, ops, op_num,
-                                call->wrapped, NULL);
-  if (error != GRPC_CALL_OK) {
+  return true;
+}
+
+/**
+ * Start a batch of RPC actions.
+ * @param array batch Array of actions to take
+ * @return object Object with results of all actions
+ */
+PHP_METHOD(Call, startBatch) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+  grpc_php_batch batch;
+  zval *array;
+
+  grpc_php_batch_init(&batch);
+  grpc_php_batch_begin(call, &batch);
+  object_init(return_value);
+
+  /* "a" == 1 array */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &array) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "start_batch expects an array", 1);
+    goto cleanup;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ARRAY(array)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (!grpc_php_batch_parse(array, &batch)) {
+    goto cleanup;
+  }
+  grpc_php_batch_run(call, &batch, return_value);
+
+cleanup:
+  grpc_php_batch_destroy(&batch);
+  RETURN_DESTROY_ZVAL(return_value);
+}
+
+/**
+ * Start a batch of RPC actions without waiting for it to complete. Its
+ * results are returned by finishBatch, and no other batch can be started on
+ * the call until then. A batch that is never finished is cancelled when the
+ * call is destroyed
+ * @param array batch Array of actions to take
+ * @return void
+ */
+PHP_METHOD(Call, startBatchAsync) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+  grpc_php_batch *batch;
+  zval *array;
+
+  /* "a" == 1 array */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &array) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "startBatchAsync expects an array", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ARRAY(array)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  batch = emalloc(sizeof(grpc_php_batch));
+  grpc_php_batch_init(batch);
+  grpc_php_batch_begin(call, batch);
+  if (!grpc_php_batch_parse(array, batch) || !batch_start(call, batch)) {
+    grpc_php_batch_destroy(batch);
+    efree(batch);
+    return;
+  }
+  call->pending_batch = batch;
+}
+
+/**
+ * Wait for the batch started by startBatchAsync to complete
+ * @return object Object with results of all actions, as returned by
+ *     startBatch
+ */
+PHP_METHOD(Call, finishBatch) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+  grpc_php_batch *batch = call->pending_batch;
+
+  if (batch == NULL) {
     zend_throw_exception(spl_ce_LogicException,
-                         "start_batch was called incorrectly",
-                         (long)error);
+                         "finishBatch expects a batch started by "
+                         "startBatchAsync", 1);
+    return;
+  }
+  call->pending_batch = NULL;
+  object_init(return_value);
+  batch_finish(call, batch, return_value);
+  grpc_php_batch_destroy(batch);
+  efree(batch);
+}
+
+/**
+ * Time the phases of the batches of this call from now on, whatever
+ * grpc.call_timings is. Their results then have a timings property with the
+ * nanoseconds spent building the batch (build_ns), waiting for it to
+ * complete (wait_ns) and converting its results (convert_ns)
+ * @param bool $enabled Whether to time the batches (optional)
+ * @return void
+ */
+PHP_METHOD(Call, enableTimings) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+  zend_bool enabled = 1;
+
+  /* "|b" == 1 optional bool */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|b", &enabled) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "enableTimings expects an optional bool", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(0, 1)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_BOOL(enabled)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  call->timed = enabled;
+}
+
+/**
+ * Get the time spent in each phase of the timed batches of this call, summed
+ * over the batches
+ * @return array ['batches' => long, 'build_ns' => long, 'wait_ns' => long,
+ *     'convert_ns' => long]
+ */
+PHP_METHOD(Call, getTimings) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  array_init_size(return_value, 4);
+  add_assoc_long(return_value, "batches", call->timings.batches);
+  add_assoc_long(return_value, "build_ns",
+                 (zend_long)call->timings.build_ns);
+  add_assoc_long(return_value, "wait_ns", (zend_long)call->timings.wait_ns);
+  add_assoc_long(return_value, "convert_ns",
+                 (zend_long)call->timings.convert_ns);
+}
+
+/**
+ * Write the slow calls logged so far instead of waiting for the end of the
+ * request, for workers that serve many requests in one PHP request
+ * @return void
+ */
+PHP_METHOD(Call, flushSlowCallLog) {
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  grpc_php_flush_slow_call_log();
+}
+
+/**
+ * Make a unary call: send the metadata, the request and the close from the
+ * client, and receive the initial metadata, the response and the status, all
+ * in a single batch.
+ * @param Channel|ChannelPool $channel The channel to make the call on
+ * @param string $method The method to call
+ * @param string $request The serialized request message
+ * @param array $metadata The metadata to send (optional)
+ * @param Timeval|long|null $deadline The absolute deadline for completing the
+ *     call, a timeout in microseconds from now, or null for no deadline
+ *     (optional)
+ * @param long $flags The write flags of the request message (optional)
+ * @param CallCredentials $creds The credentials of the call (optional)
+ * @param Call $parent The server call to propagate the deadline and the
+ *     cancellation from (optional). Defaults to the server context set with
+ *     Call::setServerContext
+ * @return array [string|null $response, stdClass $status, array $metadata],
+ *     where $status has the metadata, code and details properties, and
+ *     $metadata is the initial metadata sent by the server
+ */
+PHP_METHOD(Call, unary) {
+  zval *channel_obj;
+  zend_string *method;
+  zend_string *request;
+  zval *metadata_array = NULL;
+  zval *deadline_zval = NULL;
+  zend_long flags = 0;
+  zval *creds_obj = NULL;
+  zval *parent_obj = NULL;
+  grpc_call *parent;
+  wrapped_grpc_channel *channel;
+
+  grpc_op ops[6];
+  grpc_metadata_array metadata;
+  grpc_metadata_array recv_metadata;
+  grpc_metadata_array recv_trailing_metadata;
+  grpc_status_code status;
+  char *status_details = NULL;
+  size_t status_details_capacity = 0;
+  grpc_byte_buffer *send_message = NULL;
+  grpc_byte_buffer *message = NULL;
+  grpc_call *call = NULL;
+  grpc_call_error error;
+  gpr_timespec deadline;
+  gpr_timespec start_time;
+  char *target = NULL;
+  grpc_php_call_stats *method_stats;
+  char *message_str;
+  size_t message_len;
+  zval recv_status;
+  zval array;
+
+  grpc_metadata_array_init(&metadata);
+  grpc_metadata_array_init(&recv_metadata);
+  grpc_metadata_array_init(&recv_trailing_metadata);
+  memset(ops, 0, sizeof(ops));
+
+  /* "oSS|a!zlO!O!" == 1 object, 2 strings, 1 optional nullable array,
+   * 1 optional zval, 1 optional long, 2 optional nullable Objects */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "oSS|a!zlO!O!", &channel_obj,
+                            &method, &request, &metadata_array,
+                            &deadline_zval, &flags, &creds_obj,
+                            grpc_ce_call_credentials, &parent_obj,
+                            grpc_ce_call) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "unary expects a Channel, 2 Strings and optional "
+                         "metadata, deadline, flags, CallCredentials and "
+                         "parent Call", 1);
     goto cleanup;
   }
-  grpc_completion_queue_pluck(completion_queue, call->wrapped,
-                              gpr_inf_future(GPR_CLOCK_REALTIME), NULL);
-  for (int i = 0; i < op_num; i++) {
-    switch(ops[i].op) {
-      case GRPC_OP_SEND_INITIAL_METADATA:
-        add_property_bool(return_value, "send_metadata", true);
-        break;
-      case GRPC_OP_SEND_MESSAGE:
-        add_property_bool(return_value, "send_message", true);
-        break;
-      case GRPC_OP_SEND_CLOSE_FROM_CLIENT:
-        add_property_bool(return_value, "send_close", true);
-        break;
-      case GRPC_OP_SEND_STATUS_FROM_SERVER:
-        add_property_bool(return_value, "send_status", true);
-        break;
-      case GRPC_OP_RECV_INITIAL_METADATA:
-        grpc_parse_metadata_array(&recv_metadata, array);
-        add_property_zval(return_value, "metadata", array);
-        //TODO(thinkerou): right?
-        /*if (Z_REFCOUNT_P(array) == 1) {
-          ZVAL_UNREF(array);
-        } else {
-          Z_DELREF_P(array);
-        }*/
-        break;
-      case GRPC_OP_RECV_MESSAGE:
-        byte_buffer_to_string(message, &message_str, &message_len);
-        if (message_str == NULL) {
-          add_property_null(return_value, "message");
-        } else {
-          add_property_stringl(return_value, "message", message_str, message_len);
-        }
-        break;
-      case GRPC_OP_RECV_STATUS_ON_CLIENT:
-        object_init(&recv_status);
-        grpc_parse_metadata_array(&recv_trailing_metadata, array);
-        add_property_zval(&recv_status, "metadata", array);
-        //TODO(thinkerou): right?
-        /*if (Z_REFCOUNT_P(array) == 1) {
-          ZVAL_UNREF(array);
-        } else {
-          Z_DELREF_P(array);
-        }*/
-        add_property_long(&recv_status, "code", status);
-        add_property_string(&recv_status, "details", status_details);
-        add_property_zval(return_value, "status", &recv_status);
-        if (Z_REFCOUNTED(recv_status)) Z_DELREF(recv_status);
-        break;
-      case GRPC_OP_RECV_CLOSE_ON_SERVER:
-        add_property_bool(return_value, "cancelled", cancelled);
-        break;
-      default:
-        break;
+#else
+  ZEND_PARSE_PARAMETERS_START(3, 8)
+    Z_PARAM_OBJECT(channel_obj)
+    Z_PARAM_STR(method)
+    Z_PARAM_STR(request)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ARRAY_EX(metadata_array, 1, 0)
+    Z_PARAM_ZVAL(deadline_zval)
+    Z_PARAM_LONG(flags)
+    Z_PARAM_OBJECT_OF_CLASS_EX(creds_obj, grpc_ce_call_credentials, 1, 0)
+    Z_PARAM_OBJECT_OF_CLASS_EX(parent_obj, grpc_ce_call, 1, 0)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (!read_deadline(deadline_zval, &deadline)) {
+    goto cleanup;
+  }
+  if (!resolve_parent_call(parent_obj, &parent)) {
+    goto cleanup;
+  }
+  if ((channel = resolve_call_channel(&channel_obj)) == NULL) {
+    goto cleanup;
+  }
+  if (metadata_array != NULL &&
+      !create_metadata_array(metadata_array, &metadata)) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Bad metadata value given", 1);
+    goto cleanup;
+  }
+
+  call = grpc_channel_create_call(channel->wrapped, parent,
+                                  GRPC_PROPAGATE_DEFAULTS, completion_queue,
+                                  ZSTR_VAL(method), NULL, deadline, NULL);
+  /* Saved now, as callbacks may close the channel while the call runs */
+  if (grpc_php_slow_call_log_enabled()) {
+    target = grpc_channel_get_target(channel->wrapped);
+  }
+  if (creds_obj != NULL) {
+    error = grpc_call_set_credentials(
+        call, Z_WRAPPED_GRPC_CALL_CREDS_P(creds_obj)->wrapped);
+    if (error != GRPC_CALL_OK) {
+      zend_throw_exception(spl_ce_LogicException,
+                           "unary could not set the call credentials",
+                           (long)error);
+      goto cleanup;
     }
   }
 
+  ops[0].op = GRPC_OP_SEND_INITIAL_METADATA;
+  ops[0].data.send_initial_metadata.count = metadata.count;
+  ops[0].data.send_initial_metadata.metadata = metadata.metadata;
+  ops[1].op = GRPC_OP_SEND_MESSAGE;
+  ops[1].flags = flags & GRPC_WRITE_USED_MASK;
+  send_message = string_to_byte_buffer(ZSTR_VAL(request),
+                                       ZSTR_LEN(request));
+  ops[1].data.send_message = send_message;
+  ops[2].op = GRPC_OP_SEND_CLOSE_FROM_CLIENT;
+  ops[3].op = GRPC_OP_RECV_INITIAL_METADATA;
+  ops[3].data.recv_initial_metadata = &recv_metadata;
+  ops[4].op = GRPC_OP_RECV_MESSAGE;
+  ops[4].data.recv_message = &message;
+  ops[5].op = GRPC_OP_RECV_STATUS_ON_CLIENT;
+  ops[5].data.recv_status_on_client.trailing_metadata =
+      &recv_trailing_metadata;
+  ops[5].data.recv_status_on_client.status = &status;
+  ops[5].data.recv_status_on_client.status_details = &status_details;
+  ops[5].data.recv_status_on_client.status_details_capacity =
+      &status_details_capacity;
+
+  start_time = gpr_now(GPR_CLOCK_MONOTONIC);
+  GRPC_PHP_PROBE2(unary__start, ZSTR_VAL(method), ZSTR_LEN(request));
+  error = grpc_call_start_batch(call, ops, 6, call, NULL);
+  if (error != GRPC_CALL_OK) {
+    zend_throw_exception(spl_ce_LogicException,
+                         "unary could not start the call", (long)error);
+    goto cleanup;
+  }
+  method_stats = grpc_php_method_metrics_find(ZSTR_VAL(method),
+                                              ZSTR_LEN(method));
+  grpc_php_stats_call_started(&channel->stats, method_stats);
+  channel->in_flight++;
+  wait_for_batch(call);
+  channel->in_flight--;
+
+  array_init_size(return_value, 3);
+  byte_buffer_to_string(message, &message_str, &message_len);
+  grpc_php_stats_add_bytes(&channel->stats, method_stats, ZSTR_LEN(request),
+                           message_str == NULL ? 0 : message_len);
+  grpc_php_stats_call_finished(&channel->stats, method_stats, status,
+                               start_time);
+  GRPC_PHP_PROBE5(call__finish, ZSTR_VAL(method), call, status,
+                  ZSTR_LEN(request), message_str == NULL ? 0 : message_len);
+  if (grpc_php_slow_call_log_enabled()) {
+    grpc_php_slow_call slow_call = {
+      ZSTR_VAL(method), ZSTR_LEN(method), target, call, status,
+      ZSTR_LEN(request), message_str == NULL ? 0 : message_len,
+      start_time, deadline, NULL
+    };
+    grpc_php_log_slow_call(&slow_call);
+  }
+  if (message_str == NULL) {
+    add_next_index_null(return_value);
+  } else {
+    add_next_index_stringl(return_value, message_str, message_len);
+    efree(message_str);
+  }
+  object_init(&recv_status);
+  grpc_parse_metadata_array(&recv_trailing_metadata, &array);
+  add_property_zval(&recv_status, "metadata", &array);
+  zval_ptr_dtor(&array);
+  add_property_long(&recv_status, "code", status);
+  add_property_string(&recv_status, "details",
+                      status_details == NULL ? "" : status_details);
+  add_next_index_zval(return_value, &recv_status);
+  grpc_parse_metadata_array(&recv_metadata, &array);
+  add_next_index_zval(return_value, &array);
+
 cleanup:
   grpc_metadata_array_destroy(&metadata);
-  grpc_metadata_array_destroy(&trailing_metadata);
   grpc_metadata_array_destroy(&recv_metadata);
   grpc_metadata_array_destroy(&recv_trailing_metadata);
   if (status_details != NULL) {
     gpr_free(status_details);
   }
-  for (int i = 0; i < op_num; i++) {
-    if (ops[i].op == GRPC_OP_SEND_MESSAGE) {
-      grpc_byte_buffer_destroy(ops[i].data.send_message);
-    }
-    if (ops[i].op == GRPC_OP_RECV_MESSAGE) {
-      grpc_byte_buffer_destroy(message);
-    }
+  /* Core reads the request from this buffer until the batch completes */
+  if (send_message != NULL) {
+    grpc_byte_buffer_destroy(send_message);
+  }
+  if (message != NULL) {
+    grpc_byte_buffer_destroy(message);
+  }
+  if (call != NULL) {
+    grpc_call_destroy(call);
+  }
+  if (target != NULL) {
+    gpr_free(target);
   }
-  RETURN_DESTROY_ZVAL(return_value);
 }
 
 /**
@@ -531,7 +1268,9 @@ cleanup:
  */
 PHP_METHOD(Call, getPeer) {
   wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
-  RETURN_STRING(grpc_call_get_peer(call->wrapped));
+  char *peer = grpc_call_get_peer(call->wrapped);
+  RETVAL_STRING(peer);
+  gpr_free(peer);
 }
 
 /**
@@ -573,12 +1312,174 @@ PHP_METHOD(Call, setCredentials) {
   RETURN_LONG(error);
 }
 
+/**
+ * Set the deserializer of the messages received on this call. It is resolved
+ * once here, and then called directly with each received message, which
+ * startBatch returns deserialized.
+ * @param mixed $deserializer A callable taking the serialized message, or the
+ *                            name of a message class with a static decode
+ *                            method. With $instance, the name of the method
+ *                            of $instance that merges a serialized message
+ *                            into it. Null returns messages as strings again
+ * @param object $instance The message instance to merge each received
+ *                         message into and return (optional)
+ * @return void
+ */
+PHP_METHOD(Call, setDeserializer) {
+  wrapped_grpc_call *call = Z_WRAPPED_GRPC_CALL_P(getThis());
+  zval *deserializer;
+  zval *instance = NULL;
+  zval callable;
+  zend_fcall_info fci;
+  zend_fcall_info_cache fcc;
+  char *error = NULL;
+
+  /* "z|o!" == 1 zval, 1 optional nullable object */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "z|o!", &deserializer,
+                            &instance) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "setDeserializer expects a deserializer and an "
+                         "optional message instance", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 2)
+    Z_PARAM_ZVAL(deserializer)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_OBJECT_EX(instance, 1, 0)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (Z_TYPE_P(deserializer) == IS_NULL) {
+    if (instance != NULL) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "A message instance needs the name of its merge "
+                           "method", 1);
+      return;
+    }
+    call->has_deserializer = false;
+    zval_ptr_dtor(&call->deserializer_callable);
+    zval_ptr_dtor(&call->deserialize_into);
+    ZVAL_UNDEF(&call->deserializer_callable);
+    ZVAL_UNDEF(&call->deserialize_into);
+    return;
+  }
+
+  if (instance != NULL) {
+    if (Z_TYPE_P(deserializer) != IS_STRING) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "A message instance needs the name of its merge "
+                           "method", 1);
+      return;
+    }
+    array_init_size(&callable, 2);
+    add_next_index_zval(&callable, instance);
+    Z_ADDREF_P(instance);
+    add_next_index_str(&callable, zend_string_copy(Z_STR_P(deserializer)));
+  } else if (Z_TYPE_P(deserializer) == IS_STRING &&
+             !zend_is_callable(deserializer, 0, NULL) &&
+             zend_lookup_class(Z_STR_P(deserializer)) != NULL) {
+    array_init_size(&callable, 2);
+    add_next_index_str(&callable, zend_string_copy(Z_STR_P(deserializer)));
+    add_next_index_stringl(&callable, "decode", sizeof("decode") - 1);
+  } else {
+    ZVAL_COPY(&callable, deserializer);
+  }
+
+  if (zend_fcall_info_init(&callable, 0, &fci, &fcc, NULL, &error) ==
+      FAILURE) {
+    if (error != NULL) {
+      efree(error);
+    }
+    zval_ptr_dtor(&callable);
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "setDeserializer expects a callable or the name of "
+                         "a message class", 1);
+    return;
+  }
+  if (error != NULL) {
+    efree(error);
+  }
+
+  zval_ptr_dtor(&call->deserializer_callable);
+  zval_ptr_dtor(&call->deserialize_into);
+  /* fci refers to the function name held by the callable */
+  ZVAL_COPY_VALUE(&call->deserializer_callable, &callable);
+  call->deserializer = fci;
+  call->deserializer_cache = fcc;
+  if (instance != NULL) {
+    ZVAL_COPY(&call->deserialize_into, instance);
+  } else {
+    ZVAL_UNDEF(&call->deserialize_into);
+  }
+  call->has_deserializer = true;
+}
+
+/**
+ * Set the server call that client calls made while handling it propagate
+ * their deadline and cancellation from, when no parent call is given.
+ * The server context is cleared at the end of the request.
+ * @param Call $call The call received by the server, or null to clear it
+ * @return void
+ */
+PHP_METHOD(Call, setServerContext) {
+  zval *call_obj;
+
+  /* "O!" == 1 nullable Object */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "O!", &call_obj,
+                            grpc_ce_call) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "setServerContext expects a Call or null", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_OBJECT_OF_CLASS_EX(call_obj, grpc_ce_call, 1, 0)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (call_obj != NULL && !is_server_call(call_obj)) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "The server context must be a call received by a "
+                         "server", 1);
+    return;
+  }
+  zval_ptr_dtor(&GRPC_G(server_context));
+  if (call_obj != NULL) {
+    ZVAL_COPY(&GRPC_G(server_context), call_obj);
+  } else {
+    ZVAL_UNDEF(&GRPC_G(server_context));
+  }
+}
+
+/**
+ * Get the server call set with Call::setServerContext.
+ * @return Call|null The server context, or null if none is set
+ */
+PHP_METHOD(Call, getServerContext) {
+  if (Z_TYPE(GRPC_G(server_context)) != IS_OBJECT) {
+    RETURN_NULL();
+  }
+  RETURN_ZVAL(&GRPC_G(server_context), 1, 0);
+}
+
 static zend_function_entry call_methods[] = {
     PHP_ME(Call, __construct, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
     PHP_ME(Call, startBatch, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, startBatchAsync, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, finishBatch, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, unary, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Call, getPeer, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Call, cancel, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Call, setCredentials, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, setDeserializer, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, enableTimings, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, getTimings, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Call, flushSlowCallLog, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Call, setServerContext, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Call, getServerContext, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_FE_END
 };
 
@@ -592,3 +1493,9 @@ void grpc_init_call() {
   call_object_handlers_call.offset = XtOffsetOf(wrapped_grpc_call, std);
   call_object_handlers_call.free_obj = free_wrapped_grpc_call;
 }
+
+void grpc_rshutdown_call() {
+  cancel_live_calls();
+  zval_ptr_dtor(&GRPC_G(server_context));
+  ZVAL_UNDEF(&GRPC_G(server_context));
+}
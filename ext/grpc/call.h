@@ -44,6 +44,22 @@
 #include "php_grpc.h"
 
 #include <grpc/grpc.h>
+#include <grpc/support/time.h>
+
+#include "stats.h"
+
+/* Time spent in each phase of the batches of a call, in nanoseconds */
+typedef struct grpc_php_call_timings {
+  zend_long batches;
+  /* From the start of the conversion of the PHP ops to grpc_call_start_batch */
+  int64_t build_ns;
+  /* From grpc_call_start_batch to the completion of the batch, which includes
+   * the queueing, the network and the peer */
+  int64_t wait_ns;
+  /* From the completion of the batch to the end of the conversion of its
+   * results, including the deserialization of messages */
+  int64_t convert_ns;
+} grpc_php_call_timings;
 
 /* Class entry for the Call PHP class */
 extern zend_class_entry *grpc_ce_call;
@@ -52,6 +68,43 @@ extern zend_class_entry *grpc_ce_call;
 typedef struct wrapped_grpc_call {
   bool owned;
   grpc_call *wrapped;
+  /* The Channel object a client call was created on, undefined for server
+   * calls */
+  zval channel;
+  /* Whether the call is counted in its channel's calls in flight */
+  bool in_flight;
+  /* When a client call was created, on the monotonic clock */
+  gpr_timespec start_time;
+  /* The shared counters of the method of a client call, or NULL */
+  grpc_php_call_stats *method_stats;
+  /* The method and deadline of a client call and the bytes of the messages
+   * it sent and received, for the slow call log */
+  zend_string *method;
+  gpr_timespec deadline;
+  /* The target of the channel, saved at creation while the slow call log is
+   * enabled since the channel may be closed before the call completes */
+  char *target;
+  size_t bytes_sent;
+  size_t bytes_received;
+  /* The deserializer of received messages, resolved once in
+   * setDeserializer. Messages are returned as strings without one */
+  bool has_deserializer;
+  zval deserializer_callable;
+  zend_fcall_info deserializer;
+  zend_fcall_info_cache deserializer_cache;
+  /* The message instance received messages are merged into, if any */
+  zval deserialize_into;
+  /* Links in the calls of the request, which are cancelled if they are still
+   * open when the request ends or is aborted */
+  bool live;
+  struct wrapped_grpc_call *prev_live;
+  struct wrapped_grpc_call *next_live;
+  /* Whether the phases of the batches are timed, and their sum */
+  bool timed;
+  grpc_php_call_timings timings;
+  /* The batch started by startBatchAsync that has not been finished yet, or
+   * NULL */
+  struct grpc_php_batch *pending_batch;
   zend_object std;
 } wrapped_grpc_call;
 
@@ -62,9 +115,64 @@ static inline wrapped_grpc_call *wrapped_grpc_call_from_obj(zend_object *obj) {
 
 #define Z_WRAPPED_GRPC_CALL_P(zv) wrapped_grpc_call_from_obj(Z_OBJ_P((zv)))
 
+/* Maximum number of ops in a batch, one of each type */
+#define GRPC_PHP_MAX_BATCH_OPS 8
+
+/* The ops of a batch and the buffers they send from and receive into */
+typedef struct grpc_php_batch {
+  grpc_op ops[GRPC_PHP_MAX_BATCH_OPS];
+  size_t op_num;
+  grpc_metadata_array metadata;
+  grpc_metadata_array trailing_metadata;
+  grpc_metadata_array recv_metadata;
+  grpc_metadata_array recv_trailing_metadata;
+  grpc_status_code status;
+  char *status_details;
+  size_t status_details_capacity;
+  grpc_byte_buffer *message;
+  int cancelled;
+  /* When the conversion of the ops started, if the call is timed and the
+   * batch was built from PHP values */
+  gpr_timespec build_start;
+  /* When the batch was started, if the call is timed */
+  gpr_timespec started;
+} grpc_php_batch;
+
 /* Initializes the Call PHP class */
 void grpc_init_call();
 
+/* Cancels the calls that are still open at the end of the request and
+ * releases the server context of the request */
+void grpc_rshutdown_call();
+
+/* Initializes an empty batch */
+void grpc_php_batch_init(grpc_php_batch *batch);
+
+/* Frees the buffers of a batch, including the messages of its send ops */
+void grpc_php_batch_destroy(grpc_php_batch *batch);
+
+/* Marks the start of the conversion of the ops of a batch for a timed call */
+static inline void grpc_php_batch_begin(wrapped_grpc_call *call,
+                                        grpc_php_batch *batch) {
+  if (call->timed) {
+    batch->build_start = gpr_now(GPR_CLOCK_MONOTONIC);
+  }
+}
+
+/* Adds the ops of a batch given as to Call::startBatch to an empty batch.
+ * Throws and returns false if the array is not a valid batch */
+bool grpc_php_batch_parse(zval *array, grpc_php_batch *batch);
+
+/* Starts the ops of a batch on a call and waits for them to complete, then
+ * adds their results to the result object as Call::startBatch does. The
+ * receiving ops only need their type to be set. Throws and returns false if
+ * the batch could not be started */
+bool grpc_php_batch_run(wrapped_grpc_call *call, grpc_php_batch *batch,
+                        zval *result);
+
+/* Removes a client call from its channel's calls in flight */
+void grpc_php_call_done(wrapped_grpc_call *call);
+
 /* Creates a Call object that wraps the given grpc_call struct */
 void grpc_php_wrap_call(grpc_call *wrapped, bool owned, zval *call_object);
 
@@ -47,14 +47,85 @@
 
 #include <zend_exceptions.h>
 #include <zend_hash.h>
+#include <zend_smart_str.h>
 
 #include <grpc/grpc.h>
 #include <grpc/grpc_security.h>
+#include <grpc/support/alloc.h>
+#include <grpc/support/atm.h>
+#include <grpc/support/string_util.h>
+#include <grpc/support/sync.h>
+#include <grpc/support/time.h>
 
 zend_class_entry *grpc_ce_call_credentials;
 
 static zend_object_handlers call_creds_object_handlers_call_creds;
 
+/* Maximum number of (cache key, service url) pairs kept in the cache */
+#define PLUGIN_METADATA_CACHE_SIZE 1024
+
+/* Metadata returned by a plugin callback, kept across requests */
+typedef struct plugin_metadata_cache_entry {
+  grpc_metadata *metadata;
+  size_t count;
+  gpr_timespec expiry;
+} plugin_metadata_cache_entry;
+
+static HashTable plugin_metadata_cache;
+static gpr_mu plugin_metadata_cache_mu;
+
+/* Number of the next plugin created without a cache key */
+static gpr_atm plugin_cache_namespaces = 0;
+
+/* Copies count metadata elements, including their keys and values, into
+ * memory that is independent of the PHP request */
+static grpc_metadata *copy_metadata(grpc_metadata *metadata, size_t count) {
+  grpc_metadata *copy = gpr_malloc((count == 0 ? 1 : count) *
+                                   sizeof(grpc_metadata));
+  size_t i;
+  memset(copy, 0, (count == 0 ? 1 : count) * sizeof(grpc_metadata));
+  for (i = 0; i < count; i++) {
+    char *value = gpr_malloc(metadata[i].value_length + 1);
+    memcpy(value, metadata[i].value, metadata[i].value_length);
+    value[metadata[i].value_length] = '\0';
+    copy[i].key = gpr_strdup(metadata[i].key);
+    copy[i].value = value;
+    copy[i].value_length = metadata[i].value_length;
+  }
+  return copy;
+}
+
+static void free_metadata(grpc_metadata *metadata, size_t count) {
+  size_t i;
+  for (i = 0; i < count; i++) {
+    gpr_free((void *)metadata[i].key);
+    gpr_free((void *)metadata[i].value);
+  }
+  gpr_free(metadata);
+}
+
+static void free_plugin_metadata_cache_entry(zval *data) {
+  plugin_metadata_cache_entry *entry =
+    (plugin_metadata_cache_entry *)Z_PTR_P(data);
+  free_metadata(entry->metadata, entry->count);
+  pefree(entry, 1);
+}
+
+/* Removes the cache entries that have expired at now */
+static int evict_expired_entry(zval *data, void *now) {
+  plugin_metadata_cache_entry *entry =
+    (plugin_metadata_cache_entry *)Z_PTR_P(data);
+  if (gpr_time_cmp(*(gpr_timespec *)now, entry->expiry) >= 0) {
+    return ZEND_HASH_APPLY_REMOVE;
+  }
+  return ZEND_HASH_APPLY_KEEP;
+}
+
+/* Removes the entry that was added to the cache first */
+static int evict_oldest_entry(zval *data) {
+  return ZEND_HASH_APPLY_REMOVE | ZEND_HASH_APPLY_STOP;
+}
+
 /* Frees and destroys an instance of wrapped_grpc_call_credentials */
 static void free_wrapped_grpc_call_credentials(zend_object *object) {
   wrapped_grpc_call_credentials *creds =
@@ -127,30 +198,45 @@ PHP_METHOD(CallCredentials, createComposite) {
 /**
  * Create a call credentials object from the plugin API
  * @param function callback The callback function
+ * @param array options Caching options (optional):
+ *     - 'cache_ttl': seconds for which the metadata returned for a service
+ *       url is served from the cache without invoking the callback
+ *     - 'cache_refresh_ahead': seconds before expiry from which the callback
+ *       is invoked again; the cached metadata is still served if it fails
+ *     - 'cache_key': string naming the token source; plugins created with
+ *       the same key share cached metadata, including across requests.
+ *       Without it, the cached metadata is only served to this plugin
  * @return CallCredentials The new call credentials object
  */
 PHP_METHOD(CallCredentials, createFromPlugin) {
   zend_fcall_info *fci;
   zend_fcall_info_cache *fci_cache;
+  zval *options = NULL;
+  zval *option;
+  zend_string *cache_key = NULL;
+  smart_str namespace = {0};
 
   fci = (zend_fcall_info *)emalloc(sizeof(zend_fcall_info));
   fci_cache = (zend_fcall_info_cache *)emalloc(sizeof(zend_fcall_info_cache));
   memset(fci, 0, sizeof(zend_fcall_info));
   memset(fci_cache, 0, sizeof(zend_fcall_info_cache));
 
-  /* "f" == 1 function */
+  /* "f|a" == 1 function, 1 optional array */
 #ifndef FAST_ZPP 
-  if (zend_parse_parameters(ZEND_NUM_ARGS(), "f", fci,
-                            fci_cache, fci->params,
-                            fci->param_count) == FAILURE) {
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "f|a", fci,
+                            fci_cache, &options) == FAILURE) {
     zend_throw_exception(spl_ce_InvalidArgumentException,
-                         "createFromPlugin expects 1 callback", 1);
+                         "createFromPlugin expects 1 callback and an "
+                         "optional array", 1);
+    efree(fci);
+    efree(fci_cache);
     return;
   }
 #else
-  ZEND_PARSE_PARAMETERS_START(1, -1)
+  ZEND_PARSE_PARAMETERS_START(1, 2)
     Z_PARAM_FUNC(*fci, *fci_cache)
-    Z_PARAM_VARIADIC("*", fci->params, fci->param_count)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_ARRAY(options)
   ZEND_PARSE_PARAMETERS_END();
 #endif
 
@@ -162,6 +248,41 @@ PHP_METHOD(CallCredentials, createFromPlugin) {
   state->fci = fci;
   state->fci_cache = fci_cache;
 
+  if (options != NULL) {
+    if ((option = zend_hash_str_find(Z_ARRVAL_P(options), "cache_ttl",
+                                     sizeof("cache_ttl") - 1)) != NULL) {
+      state->cache_ttl = zval_get_long(option);
+    }
+    if ((option = zend_hash_str_find(Z_ARRVAL_P(options),
+                                     "cache_refresh_ahead",
+                                     sizeof("cache_refresh_ahead") - 1))
+        != NULL) {
+      state->cache_refresh_ahead = zval_get_long(option);
+    }
+    if ((option = zend_hash_str_find(Z_ARRVAL_P(options), "cache_key",
+                                     sizeof("cache_key") - 1)) != NULL) {
+      cache_key = zval_get_string(option);
+    }
+  }
+  if (state->cache_ttl > 0) {
+    /* The prefixes keep the keys given by users apart from the namespaces
+     * of single plugins */
+    if (cache_key != NULL) {
+      smart_str_appends(&namespace, "key:");
+      smart_str_append(&namespace, cache_key);
+    } else {
+      smart_str_appends(&namespace, "plugin:");
+      smart_str_append_long(&namespace, (zend_long)
+          gpr_atm_no_barrier_fetch_add(&plugin_cache_namespaces, 1));
+      state->private_cache = true;
+    }
+    smart_str_0(&namespace);
+    state->cache_key = namespace.s;
+  }
+  if (cache_key != NULL) {
+    zend_string_release(cache_key);
+  }
+
   grpc_metadata_credentials_plugin plugin;
   plugin.get_metadata = plugin_get_metadata;
   plugin.destroy = plugin_destroy_state;
@@ -179,6 +300,38 @@ void plugin_get_metadata(void *ptr, grpc_auth_metadata_context context,
                          grpc_credentials_plugin_metadata_cb cb,
                          void *user_data) {
   plugin_state *state = (plugin_state *)ptr;
+  smart_str cache_key = {0};
+  plugin_metadata_cache_entry *entry;
+  grpc_metadata *cached = NULL;
+  size_t cached_count = 0;
+  gpr_timespec now = gpr_now(GPR_CLOCK_MONOTONIC);
+
+  if (state->cache_ttl > 0) {
+    smart_str_append(&cache_key, state->cache_key);
+    smart_str_appendc(&cache_key, '\n');
+    smart_str_appends(&cache_key, context.service_url);
+    smart_str_0(&cache_key);
+
+    gpr_mu_lock(&plugin_metadata_cache_mu);
+    entry = zend_hash_str_find_ptr(&plugin_metadata_cache,
+                                   ZSTR_VAL(cache_key.s),
+                                   ZSTR_LEN(cache_key.s));
+    if (entry != NULL && gpr_time_cmp(now, entry->expiry) < 0) {
+      cached = copy_metadata(entry->metadata, entry->count);
+      cached_count = entry->count;
+      if (gpr_time_cmp(now, gpr_time_sub(
+              entry->expiry, gpr_time_from_seconds(state->cache_refresh_ahead,
+                                                   GPR_TIMESPAN))) < 0) {
+        /* Fresh entry: serve it without running any PHP code */
+        gpr_mu_unlock(&plugin_metadata_cache_mu);
+        cb(user_data, cached, cached_count, GRPC_STATUS_OK, NULL);
+        free_metadata(cached, cached_count);
+        smart_str_free(&cache_key);
+        return;
+      }
+    }
+    gpr_mu_unlock(&plugin_metadata_cache_mu);
+  }
 
   /* prepare to call the user callback function with info from the
    * grpc_auth_metadata_context */
@@ -192,20 +345,51 @@ void plugin_get_metadata(void *ptr, grpc_auth_metadata_context context,
   state->fci->retval = &retval;
 
   /* call the user callback function */
+  ZVAL_UNDEF(&retval);
   zend_call_function(state->fci, state->fci_cache);
+  zval_ptr_dtor(&arg);
 
-  if (Z_TYPE_P(&retval) != IS_ARRAY) {
-    zend_throw_exception(spl_ce_InvalidArgumentException,
-                         "plugin callback must return metadata array", 1);
-    return;
+  grpc_metadata_array metadata;
+  grpc_metadata_array_init(&metadata);
+  if (Z_TYPE_P(&retval) != IS_ARRAY ||
+      !create_metadata_array(&retval, &metadata)) {
+    if (cached != NULL) {
+      /* The refresh failed but the cached metadata has not expired yet */
+      cb(user_data, cached, cached_count, GRPC_STATUS_OK, NULL);
+    } else if (Z_TYPE_P(&retval) != IS_ARRAY) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "plugin callback must return metadata array", 1);
+    } else {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "invalid metadata", 1);
+    }
+    goto cleanup;
   }
 
-  grpc_metadata_array metadata;
-  if (!create_metadata_array(&retval, &metadata)) {
-    zend_throw_exception(spl_ce_InvalidArgumentException,
-                         "invalid metadata", 1);
-    grpc_metadata_array_destroy(&metadata);
-    return;
+  if (state->cache_ttl > 0) {
+    gpr_mu_lock(&plugin_metadata_cache_mu);
+    if (zend_hash_num_elements(&plugin_metadata_cache) >=
+        PLUGIN_METADATA_CACHE_SIZE &&
+        !zend_hash_str_exists(&plugin_metadata_cache, ZSTR_VAL(cache_key.s),
+                              ZSTR_LEN(cache_key.s))) {
+      /* Make room for the new pair: drop the expired entries, or else the
+       * oldest one */
+      zend_hash_apply_with_argument(&plugin_metadata_cache,
+                                    evict_expired_entry, &now);
+      if (zend_hash_num_elements(&plugin_metadata_cache) >=
+          PLUGIN_METADATA_CACHE_SIZE) {
+        zend_hash_apply(&plugin_metadata_cache, evict_oldest_entry);
+      }
+    }
+    entry = pemalloc(sizeof(plugin_metadata_cache_entry), 1);
+    entry->metadata = copy_metadata(metadata.metadata, metadata.count);
+    entry->count = metadata.count;
+    entry->expiry = gpr_time_add(
+        now, gpr_time_from_seconds(state->cache_ttl, GPR_TIMESPAN));
+    /* The str variant allocates a persistent copy of the key */
+    zend_hash_str_update_ptr(&plugin_metadata_cache, ZSTR_VAL(cache_key.s),
+                             ZSTR_LEN(cache_key.s), entry);
+    gpr_mu_unlock(&plugin_metadata_cache_mu);
   }
 
   /* TODO: handle error */
@@ -213,11 +397,43 @@ void plugin_get_metadata(void *ptr, grpc_auth_metadata_context context,
 
   /* Pass control back to core */
   cb(user_data, metadata.metadata, metadata.count, code, NULL);
+
+cleanup:
+  grpc_metadata_array_destroy(&metadata);
+  zval_ptr_dtor(&retval);
+  if (cached != NULL) {
+    free_metadata(cached, cached_count);
+  }
+  smart_str_free(&cache_key);
+}
+
+/* Tells the cache to drop an entry in the namespace given as the argument */
+static int drop_namespace_entry(zval *entry, int num_args, va_list args,
+                                zend_hash_key *hash_key) {
+  zend_string *namespace = va_arg(args, zend_string *);
+  if (hash_key->key != NULL &&
+      ZSTR_LEN(hash_key->key) > ZSTR_LEN(namespace) &&
+      memcmp(ZSTR_VAL(hash_key->key), ZSTR_VAL(namespace),
+             ZSTR_LEN(namespace)) == 0 &&
+      ZSTR_VAL(hash_key->key)[ZSTR_LEN(namespace)] == '\n') {
+    return ZEND_HASH_APPLY_REMOVE;
+  }
+  return ZEND_HASH_APPLY_KEEP;
 }
 
 /* Cleanup function for plugin creds API */
 void plugin_destroy_state(void *ptr) {
   plugin_state *state = (plugin_state *)ptr;
+  if (state->private_cache) {
+    /* Nothing else can hit the entries of this plugin */
+    gpr_mu_lock(&plugin_metadata_cache_mu);
+    zend_hash_apply_with_arguments(&plugin_metadata_cache,
+                                   drop_namespace_entry, 1, state->cache_key);
+    gpr_mu_unlock(&plugin_metadata_cache_mu);
+  }
+  if (state->cache_key != NULL) {
+    zend_string_release(state->cache_key);
+  }
   efree(state->fci);
   efree(state->fci_cache);
   efree(state);
@@ -243,4 +459,12 @@ void grpc_init_call_credentials() {
     XtOffsetOf(wrapped_grpc_call_credentials, std);
   call_creds_object_handlers_call_creds.free_obj =
     free_wrapped_grpc_call_credentials;
+  zend_hash_init(&plugin_metadata_cache, 16, NULL,
+                 free_plugin_metadata_cache_entry, 1);
+  gpr_mu_init(&plugin_metadata_cache_mu);
+}
+
+void grpc_shutdown_call_credentials() {
+  zend_hash_destroy(&plugin_metadata_cache);
+  gpr_mu_destroy(&plugin_metadata_cache_mu);
 }
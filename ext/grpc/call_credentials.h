@@ -69,6 +69,15 @@ static inline wrapped_grpc_call_credentials *wrapped_grpc_call_creds_from_obj(
 typedef struct plugin_state {
   zend_fcall_info *fci;
   zend_fcall_info_cache *fci_cache;
+  /* Lifetime in seconds of cached callback results, 0 disables caching */
+  zend_long cache_ttl;
+  /* Seconds before expiry at which the callback is invoked again */
+  zend_long cache_refresh_ahead;
+  /* Namespace of the cache entries of this plugin */
+  zend_string *cache_key;
+  /* Whether the namespace belongs to this plugin alone, in which case its
+   * entries are dropped with it */
+  bool private_cache;
 } plugin_state;
 
 /* Callback function for plugin creds API */
@@ -82,4 +91,7 @@ void plugin_destroy_state(void *ptr);
 /* Initializes the CallCredentials PHP class */
 void grpc_init_call_credentials();
 
+/* Frees the plugin metadata cache */
+void grpc_shutdown_call_credentials();
+
 #endif /* NET_GRPC_PHP_GRPC_CALL_CREDENTIALS_H_ */
@@ -41,17 +41,23 @@
 #include <php_ini.h>
 #include <ext/standard/info.h>
 #include <ext/spl/spl_exceptions.h>
+#include <ext/standard/php_string.h>
 #include "php_grpc.h"
 
 #include <zend_exceptions.h>
+#include <zend_smart_str.h>
 
 #include <stdbool.h>
 
 #include <grpc/grpc.h>
 #include <grpc/grpc_security.h>
+#include <grpc/support/alloc.h>
+#include <grpc/support/sync.h>
+#include <grpc/support/time.h>
 
 #include "completion_queue.h"
 #include "channel_credentials.h"
+#include "channel_pool.h"
 #include "server.h"
 #include "timeval.h"
 
@@ -59,12 +65,129 @@ zend_class_entry *grpc_ce_channel;
 
 static zend_object_handlers channel_object_handlers_channel;
 
+#ifndef GRPC_ARG_KEEPALIVE_TIME_MS
+#define GRPC_ARG_KEEPALIVE_TIME_MS "grpc.keepalive_time_ms"
+#endif
+
+/* Persistent channels by key, see persistent_channel_key */
+static HashTable persistent_channels;
+static gpr_mu persistent_channels_mu;
+
+/* Destroys a persistent channel when it is removed from the registry */
+static void free_persistent_channel(zval *entry) {
+  grpc_php_persistent_channel *persistent = Z_PTR_P(entry);
+  grpc_channel_destroy(persistent->channel);
+  pefree(persistent, 1);
+}
+
+/* Builds the registry key of a channel. Every argument is part of it,
+ * including the primary user agent, which the channel sends with each call */
+static void persistent_channel_key(smart_str *key, const char *target,
+                                   grpc_channel_args *args,
+                                   grpc_channel_credentials *creds) {
+  char creds_buf[32];
+  size_t i;
+  smart_str_appends(key, target);
+  for (i = 0; i < args->num_args; i++) {
+    smart_str_appendc(key, '\n');
+    smart_str_appends(key, args->args[i].key);
+    if (args->args[i].type == GRPC_ARG_INTEGER) {
+      smart_str_appends(key, "=i:");
+      smart_str_append_long(key, args->args[i].value.integer);
+    } else {
+      smart_str_appends(key, "=s:");
+      smart_str_appends(key, args->args[i].value.string);
+    }
+  }
+  /* Only credentials kept by the registry are ever shared, so their address
+   * identifies them for the lifetime of the process */
+  snprintf(creds_buf, sizeof(creds_buf), "\n%p", (void *)creds);
+  smart_str_appends(key, creds_buf);
+  smart_str_0(key);
+}
+
+/* Appends the arguments set by the INI settings unless args sets them */
+static void add_default_channel_args(grpc_channel_args *args) {
+  size_t i;
+  if (GRPC_G(default_keepalive_ms) <= 0) {
+    return;
+  }
+  for (i = 0; i < args->num_args; i++) {
+    if (strcmp(args->args[i].key, GRPC_ARG_KEEPALIVE_TIME_MS) == 0) {
+      return;
+    }
+  }
+  args->args = erealloc(args->args, (args->num_args + 1) * sizeof(grpc_arg));
+  args->args[args->num_args].type = GRPC_ARG_INTEGER;
+  args->args[args->num_args].key = GRPC_ARG_KEEPALIVE_TIME_MS;
+  args->args[args->num_args].value.integer =
+      (int)GRPC_G(default_keepalive_ms);
+  args->num_args++;
+}
+
+/* Creates an insecure channel if creds is NULL, or else a secure channel */
+static grpc_channel *create_grpc_channel(const char *target,
+                                         grpc_channel_args *args,
+                                         grpc_channel_credentials *creds) {
+  if (creds == NULL) {
+    return grpc_insecure_channel_create(target, args, NULL);
+  }
+  return grpc_secure_channel_create(creds, target, args, NULL);
+}
+
+/* Returns the persistent channel for target, args and creds with one more
+ * reference, opening it if there is room left in the registry. Returns NULL
+ * if the registry is full */
+static grpc_php_persistent_channel *acquire_persistent_channel(
+    const char *target, grpc_channel_args *args,
+    grpc_channel_credentials *creds) {
+  smart_str key = {0};
+  grpc_php_persistent_channel *persistent;
+  persistent_channel_key(&key, target, args, creds);
+  gpr_mu_lock(&persistent_channels_mu);
+  persistent = zend_hash_str_find_ptr(&persistent_channels, ZSTR_VAL(key.s),
+                                      ZSTR_LEN(key.s));
+  if (persistent == NULL &&
+      zend_hash_num_elements(&persistent_channels) <
+      GRPC_G(max_persistent_channels)) {
+    persistent = pemalloc(sizeof(grpc_php_persistent_channel), 1);
+    persistent->channel = create_grpc_channel(target, args, creds);
+    persistent->refs = 0;
+    zend_hash_str_add_ptr(&persistent_channels, ZSTR_VAL(key.s),
+                          ZSTR_LEN(key.s), persistent);
+  }
+  if (persistent != NULL) {
+    persistent->refs++;
+    persistent->last_used = gpr_now(GPR_CLOCK_MONOTONIC);
+  }
+  gpr_mu_unlock(&persistent_channels_mu);
+  smart_str_free(&key);
+  return persistent;
+}
+
+/* Drops a reference to a persistent channel, which stays open */
+static void release_persistent_channel(
+    grpc_php_persistent_channel *persistent) {
+  gpr_mu_lock(&persistent_channels_mu);
+  persistent->refs--;
+  persistent->last_used = gpr_now(GPR_CLOCK_MONOTONIC);
+  gpr_mu_unlock(&persistent_channels_mu);
+}
+
+void grpc_php_release_channel(wrapped_grpc_channel *channel) {
+  if (channel->persistent != NULL) {
+    release_persistent_channel(channel->persistent);
+    channel->persistent = NULL;
+  } else if (channel->wrapped != NULL) {
+    grpc_channel_destroy(channel->wrapped);
+  }
+  channel->wrapped = NULL;
+}
+
 /* Frees and destroys an instance of wrapped_grpc_channel */
 static void free_wrapped_grpc_channel(zend_object *object) {
   wrapped_grpc_channel *channel = wrapped_grpc_channel_from_obj(object);
-  if (channel->wrapped != NULL) {
-    grpc_channel_destroy(channel->wrapped);
-  }
+  grpc_php_release_channel(channel);
   zend_object_std_dtor(&channel->std);
 }
 
@@ -133,6 +256,135 @@ void php_grpc_read_args_array(zval *args_array, grpc_channel_args *args) {
   } ZEND_HASH_FOREACH_END();
 }
 
+/* Creates the grpc_channel wrapped by channel from a target and an args array
+ * as accepted by the Channel constructor. Throws an exception and leaves the
+ * channel unset if the arguments are invalid */
+void grpc_php_channel_init(wrapped_grpc_channel *channel, zend_string *target,
+                           zval *args_array) {
+  grpc_channel_args args;
+  HashTable *array_hash;
+  zval *creds_obj = NULL;
+  wrapped_grpc_channel_credentials *creds = NULL;
+
+  array_hash = HASH_OF(args_array);
+  if ((creds_obj = zend_hash_str_find(array_hash, "credentials",
+                                      sizeof("credentials") - 1)) != NULL) {
+    if (Z_TYPE_P(creds_obj) == IS_NULL) {
+      creds = NULL;
+      zend_hash_str_del(array_hash, "credentials", sizeof("credentials") - 1);
+    } else if (Z_TYPE_P(creds_obj) != IS_OBJECT ||
+               Z_OBJ_P(creds_obj)->ce != grpc_ce_channel_credentials) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "credentials must be a ChannelCredentials object",
+                           1);
+      return;
+    } else {
+      creds = Z_WRAPPED_GRPC_CHANNEL_CREDS_P(creds_obj);
+      zend_hash_str_del(array_hash, "credentials", sizeof("credentials") - 1);
+    }
+  }
+  php_grpc_read_args_array(args_array, &args);
+  add_default_channel_args(&args);
+  /* Credentials owned by the object die with the request, so only channels
+   * using registry credentials can outlive it */
+  if (GRPC_G(persistent_channels) && (creds == NULL || !creds->owned)) {
+    channel->persistent = acquire_persistent_channel(
+        ZSTR_VAL(target), &args, creds == NULL ? NULL : creds->wrapped);
+  }
+  if (channel->persistent != NULL) {
+    channel->wrapped = channel->persistent->channel;
+  } else {
+    channel->wrapped = create_grpc_channel(
+        ZSTR_VAL(target), &args, creds == NULL ? NULL : creds->wrapped);
+  }
+  efree(args.args);
+}
+
+void grpc_php_preconnect_channels() {
+  grpc_channel **channels;
+  grpc_channel_credentials *creds;
+  grpc_channel_args args;
+  grpc_php_persistent_channel *persistent;
+  char *targets;
+  char *target;
+  char *last = NULL;
+  int count = 0;
+  bool shutdown;
+
+  if (!GRPC_G(persistent_channels) || GRPC_G(preconnect_targets) == NULL ||
+      GRPC_G(preconnect_targets)[0] == '\0') {
+    return;
+  }
+  targets = estrdup(GRPC_G(preconnect_targets));
+  channels = safe_emalloc(strlen(targets), sizeof(grpc_channel *), 0);
+  for (target = php_strtok_r(targets, ", \t", &last); target != NULL;
+       target = php_strtok_r(NULL, ", \t", &last)) {
+    /* "ssl://host:port" uses the credentials of createSsl() without
+     * arguments, anything else an insecure channel */
+    creds = NULL;
+    if (strncmp(target, "ssl://", sizeof("ssl://") - 1) == 0) {
+      target += sizeof("ssl://") - 1;
+      if ((creds = grpc_php_default_ssl_channel_credentials()) == NULL) {
+        continue;
+      }
+    }
+    args.num_args = 0;
+    args.args = ecalloc(1, sizeof(grpc_arg));
+    /* The user agent is part of the registry key */
+    if (GRPC_G(preconnect_user_agent) != NULL &&
+        GRPC_G(preconnect_user_agent)[0] != '\0') {
+      args.args[0].type = GRPC_ARG_STRING;
+      args.args[0].key = GRPC_ARG_PRIMARY_USER_AGENT_STRING;
+      args.args[0].value.string = GRPC_G(preconnect_user_agent);
+      args.num_args = 1;
+    }
+    add_default_channel_args(&args);
+    persistent = acquire_persistent_channel(target, &args, creds);
+    efree(args.args);
+    if (persistent == NULL) {
+      break;
+    }
+    channels[count++] = persistent->channel;
+    release_persistent_channel(persistent);
+  }
+
+  if (count > 0) {
+    /* Start connecting even if the request does not wait, the connections
+     * then progress whenever a call is made */
+    gpr_timespec deadline = gpr_time_add(
+        gpr_now(GPR_CLOCK_MONOTONIC),
+        gpr_time_from_millis(GRPC_G(preconnect_timeout_ms), GPR_TIMESPAN));
+    grpc_php_wait_for_channels_ready(channels, count, deadline, &shutdown);
+  }
+  efree(channels);
+  efree(targets);
+}
+
+/* Tells the registry to drop a persistent channel unused since the cutoff */
+static int reap_idle_channel(zval *entry, void *cutoff) {
+  grpc_php_persistent_channel *persistent = Z_PTR_P(entry);
+  if (persistent->refs == 0 &&
+      gpr_time_cmp(persistent->last_used, *(gpr_timespec *)cutoff) < 0) {
+    return ZEND_HASH_APPLY_REMOVE;
+  }
+  return ZEND_HASH_APPLY_KEEP;
+}
+
+void grpc_php_reap_persistent_channels() {
+  gpr_timespec cutoff;
+  if (GRPC_G(persistent_channel_idle_timeout) <= 0) {
+    return;
+  }
+  cutoff = gpr_time_sub(
+      gpr_now(GPR_CLOCK_MONOTONIC),
+      gpr_time_from_seconds(GRPC_G(persistent_channel_idle_timeout),
+                            GPR_TIMESPAN));
+  gpr_mu_lock(&persistent_channels_mu);
+  zend_hash_apply_with_argument(&persistent_channels, reap_idle_channel,
+                                &cutoff);
+  gpr_mu_unlock(&persistent_channels_mu);
+}
+
 /**
  * Construct an instance of the Channel class. If the $args array contains a
  * "credentials" key mapping to a ChannelCredentials object, a secure channel
@@ -144,10 +396,6 @@ PHP_METHOD(Channel, __construct) {
   wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(getThis());
   zend_string *target;
   zval *args_array = NULL;
-  grpc_channel_args args;
-  HashTable *array_hash;
-  zval *creds_obj = NULL;
-  wrapped_grpc_channel_credentials *creds = NULL;
 
   /* "Sa" == 1 string, 1 array */
 #ifndef FAST_ZPP
@@ -164,32 +412,7 @@ PHP_METHOD(Channel, __construct) {
   ZEND_PARSE_PARAMETERS_END();
 #endif
 
-  array_hash = HASH_OF(args_array);
-  if ((creds_obj = zend_hash_str_find(array_hash, "credentials",
-                                      sizeof("credentials") - 1)) != NULL) {
-    if (Z_TYPE_P(creds_obj) == IS_NULL) {
-      creds = NULL;
-      zend_hash_str_del(array_hash, "credentials", sizeof("credentials") - 1);
-    } else if (Z_OBJ_P(creds_obj)->ce != grpc_ce_channel_credentials) {
-      zend_throw_exception(spl_ce_InvalidArgumentException,
-                           "credentials must be a ChannelCredentials object",
-                           1);
-      return;
-    } else {
-      creds = Z_WRAPPED_GRPC_CHANNEL_CREDS_P(creds_obj);
-      zend_hash_str_del(array_hash, "credentials", sizeof("credentials") - 1);
-    }
-  }
-  php_grpc_read_args_array(args_array, &args);
-  if (creds == NULL) {
-    channel->wrapped = grpc_insecure_channel_create(ZSTR_VAL(target),
-                                                    &args, NULL);
-  } else {
-    channel->wrapped =
-        grpc_secure_channel_create(creds->wrapped, ZSTR_VAL(target),
-                                   &args, NULL);
-  }
-  efree(args.args);
+  grpc_php_channel_init(channel, target, args_array);
 }
 
 /**
@@ -198,7 +421,9 @@ PHP_METHOD(Channel, __construct) {
  */
 PHP_METHOD(Channel, getTarget) {
   wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(getThis());
-  RETURN_STRING(grpc_channel_get_target(channel->wrapped));
+  char *target = grpc_channel_get_target(channel->wrapped);
+  RETVAL_STRING(target);
+  gpr_free(target);
 }
 
 /**
@@ -266,15 +491,224 @@ PHP_METHOD(Channel, watchConnectivityState) {
   RETURN_BOOL(event.success);
 }
 
+int grpc_php_wait_for_channels_ready(grpc_channel **channels, int count,
+                                     gpr_timespec deadline, bool *shutdown) {
+  grpc_completion_queue *cq = grpc_completion_queue_create(NULL);
+  grpc_connectivity_state state;
+  grpc_event event;
+  int ready = 0;
+  int pending = 0;
+  int i;
+
+  *shutdown = false;
+  /* Start watching every channel that is not ready yet before waiting on any
+   * of them, so that all the connections are established concurrently */
+  for (i = 0; i < count; i++) {
+    state = grpc_channel_check_connectivity_state(channels[i], 1);
+    if (state == GRPC_CHANNEL_READY) {
+      ready++;
+    } else if (state == GRPC_CHANNEL_SHUTDOWN) {
+      *shutdown = true;
+    } else {
+      grpc_channel_watch_connectivity_state(channels[i], state, deadline, cq,
+                                            (void *)(intptr_t)i);
+      pending++;
+    }
+  }
+
+  /* Every watch completes by the deadline at the latest */
+  while (pending > 0) {
+    event = grpc_completion_queue_next(cq, gpr_inf_future(GPR_CLOCK_REALTIME),
+                                       NULL);
+    if (event.type != GRPC_OP_COMPLETE) {
+      break;
+    }
+    pending--;
+    if (!event.success) {
+      /* The deadline passed before the state changed */
+      continue;
+    }
+    i = (int)(intptr_t)event.tag;
+    state = grpc_channel_check_connectivity_state(channels[i], 0);
+    if (state == GRPC_CHANNEL_READY) {
+      ready++;
+    } else if (state == GRPC_CHANNEL_SHUTDOWN) {
+      *shutdown = true;
+    } else {
+      grpc_channel_watch_connectivity_state(channels[i], state, deadline, cq,
+                                            (void *)(intptr_t)i);
+      pending++;
+    }
+  }
+
+  grpc_completion_queue_shutdown(cq);
+  while (grpc_completion_queue_next(cq, gpr_inf_future(GPR_CLOCK_REALTIME),
+                                    NULL).type != GRPC_QUEUE_SHUTDOWN);
+  grpc_completion_queue_destroy(cq);
+  return ready;
+}
+
+/* Appends the grpc_channels of a Channel or ChannelPool object to channels.
+ * Returns false if the object is neither, or if a channel is closed */
+static bool collect_channels(zval *obj, grpc_channel ***channels, int *count,
+                             int *capacity) {
+  wrapped_grpc_channel_pool *pool;
+  zend_long i;
+  if (Z_TYPE_P(obj) != IS_OBJECT) {
+    return false;
+  }
+  if (instanceof_function(Z_OBJCE_P(obj), grpc_ce_channel_pool)) {
+    pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(obj);
+    for (i = 0; i < pool->size; i++) {
+      if (!collect_channels(&pool->channels[i], channels, count, capacity)) {
+        return false;
+      }
+    }
+    return true;
+  }
+  if (!instanceof_function(Z_OBJCE_P(obj), grpc_ce_channel) ||
+      Z_WRAPPED_GRPC_CHANNEL_P(obj)->wrapped == NULL) {
+    return false;
+  }
+  if (*count == *capacity) {
+    *capacity = *capacity == 0 ? 8 : *capacity * 2;
+    *channels = erealloc(*channels, *capacity * sizeof(grpc_channel *));
+  }
+  (*channels)[(*count)++] = Z_WRAPPED_GRPC_CHANNEL_P(obj)->wrapped;
+  return true;
+}
+
+bool grpc_php_wait_for_ready(zval *objs, int objs_count,
+                             zend_long timeout_micros) {
+  grpc_channel **channels = NULL;
+  int count = 0;
+  int capacity = 0;
+  int ready;
+  bool shutdown;
+  int i;
+
+  for (i = 0; i < objs_count; i++) {
+    if (!collect_channels(&objs[i], &channels, &count, &capacity)) {
+      zend_throw_exception(spl_ce_InvalidArgumentException,
+                           "waitForReady expects open Channel or ChannelPool "
+                           "objects", 1);
+      if (channels != NULL) {
+        efree(channels);
+      }
+      return false;
+    }
+  }
+  if (count == 0) {
+    return true;
+  }
+
+  gpr_timespec deadline = gpr_time_add(
+      gpr_now(GPR_CLOCK_MONOTONIC),
+      gpr_time_from_micros(timeout_micros, GPR_TIMESPAN));
+  ready = grpc_php_wait_for_channels_ready(channels, count, deadline,
+                                           &shutdown);
+  efree(channels);
+  if (shutdown) {
+    zend_throw_exception(zend_exception_get_default(),
+                         "Failed to connect to server", 1);
+    return false;
+  }
+  return ready == count;
+}
+
+/**
+ * Try to connect the channel and wait until it is ready
+ * @param long $timeout The time in microseconds to wait for the channel
+ * @return bool True if the channel became ready before the timeout
+ * @throw Exception if the channel has been shut down
+ */
+PHP_METHOD(Channel, waitForReady) {
+  zend_long timeout;
+
+  /* "l" == 1 long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &timeout) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "waitForReady expects a long", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_LONG(timeout)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  RETURN_BOOL(grpc_php_wait_for_ready(getThis(), 1, timeout));
+}
+
+/**
+ * Try to connect all the channels at the same time and wait until every one
+ * of them is ready
+ * @param array $channels Channel or ChannelPool objects to wait for
+ * @param long $timeout The time in microseconds to wait for the channels
+ * @return bool True if all the channels became ready before the timeout
+ * @throw Exception if one of the channels has been shut down
+ */
+PHP_METHOD(Channel, waitAllReady) {
+  zval *channels_array;
+  zend_long timeout;
+  zval *objs;
+  zval *value;
+  int count = 0;
+
+  /* "al" == 1 array, 1 long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "al", &channels_array,
+                            &timeout) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "waitAllReady expects an array and a long", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(2, 2)
+    Z_PARAM_ARRAY(channels_array)
+    Z_PARAM_LONG(timeout)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  objs = safe_emalloc(zend_hash_num_elements(Z_ARRVAL_P(channels_array)) + 1,
+                      sizeof(zval), 0);
+  ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(channels_array), value) {
+    ZVAL_DEREF(value);
+    ZVAL_COPY_VALUE(&objs[count], value);
+    count++;
+  } ZEND_HASH_FOREACH_END();
+  RETVAL_BOOL(grpc_php_wait_for_ready(objs, count, timeout));
+  efree(objs);
+}
+
 /**
  * Close the channel
  */
 PHP_METHOD(Channel, close) {
   wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(getThis());
-  if (channel->wrapped != NULL) {
-    grpc_channel_destroy(channel->wrapped);
-    channel->wrapped = NULL;
-  }
+  grpc_php_release_channel(channel);
+}
+
+/**
+ * Check whether the channel is kept open across requests
+ * @return bool True if the channel is shared with later requests
+ */
+PHP_METHOD(Channel, isPersistent) {
+  wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(getThis());
+  RETURN_BOOL(channel->persistent != NULL);
+}
+
+/**
+ * Get the counters of the calls created on this channel object
+ * @return array The number of calls started, succeeded, failed and in
+ *     flight, the number of completed calls by status code, the bytes of
+ *     messages sent and received, and the count, mean, p50, p90, p99 and max
+ *     of the latency of the completed calls in microseconds
+ */
+PHP_METHOD(Channel, getStats) {
+  wrapped_grpc_channel *channel = Z_WRAPPED_GRPC_CHANNEL_P(getThis());
+  grpc_php_stats_to_array(&channel->stats, channel->in_flight, return_value);
 }
 
 static zend_function_entry channel_methods[] = {
@@ -282,7 +716,11 @@ static zend_function_entry channel_methods[] = {
     PHP_ME(Channel, getTarget, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Channel, getConnectivityState, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Channel, watchConnectivityState, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Channel, waitForReady, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Channel, waitAllReady, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Channel, close, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Channel, isPersistent, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Channel, getStats, NULL, ZEND_ACC_PUBLIC)
     PHP_FE_END
 };
 
@@ -296,4 +734,20 @@ void grpc_init_channel() {
   channel_object_handlers_channel.offset =
     XtOffsetOf(wrapped_grpc_channel, std);
   channel_object_handlers_channel.free_obj = free_wrapped_grpc_channel;
+  zend_hash_init(&persistent_channels, 16, NULL, free_persistent_channel, 1);
+  gpr_mu_init(&persistent_channels_mu);
+}
+
+void grpc_shutdown_channel() {
+  zend_hash_destroy(&persistent_channels);
+  gpr_mu_destroy(&persistent_channels_mu);
+}
+
+void grpc_minfo_channel() {
+  char buf[64];
+  gpr_mu_lock(&persistent_channels_mu);
+  snprintf(buf, sizeof(buf), "%u",
+           zend_hash_num_elements(&persistent_channels));
+  gpr_mu_unlock(&persistent_channels_mu);
+  php_info_print_table_row(2, "Persistent channels", buf);
 }
@@ -45,12 +45,31 @@
 
 #include <grpc/grpc.h>
 
+#include "stats.h"
+
 /* Class entry for the PHP Channel class */
 extern zend_class_entry *grpc_ce_channel;
 
+/* A channel kept open across requests and shared by the Channel objects
+ * created with the same target, arguments and credentials */
+typedef struct grpc_php_persistent_channel {
+  grpc_channel *channel;
+  /* Number of Channel objects currently using the channel */
+  zend_long refs;
+  /* When the channel was last released by a Channel object */
+  gpr_timespec last_used;
+} grpc_php_persistent_channel;
+
 /* Wrapper struct for grpc_channel that can be associated with a PHP object */
 typedef struct wrapped_grpc_channel {
   grpc_channel *wrapped;
+  /* The persistent channel wrapped is borrowed from, or NULL if the object
+   * owns wrapped */
+  grpc_php_persistent_channel *persistent;
+  /* Number of calls created on this channel that have not completed yet */
+  zend_long in_flight;
+  /* Counters of the calls created on this channel */
+  grpc_php_call_stats stats;
   zend_object std;
 } wrapped_grpc_channel;
 
@@ -66,6 +85,40 @@ static inline wrapped_grpc_channel *wrapped_grpc_channel_from_obj(
 /* Initializes the Channel class */
 void grpc_init_channel();
 
+/* Frees the process-level state shared by all channels */
+void grpc_shutdown_channel();
+
+/* Prints the channel rows of the phpinfo() section */
+void grpc_minfo_channel();
+
+/* Opens the persistent channels listed by grpc.preconnect_targets */
+void grpc_php_preconnect_channels();
+
+/* Closes the persistent channels that have been unused for longer than
+ * grpc.persistent_channel_idle_timeout */
+void grpc_php_reap_persistent_channels();
+
+/* Creates the grpc_channel wrapped by channel from a target and an args array
+ * as accepted by the Channel constructor */
+void grpc_php_channel_init(wrapped_grpc_channel *channel, zend_string *target,
+                           zval *args_array);
+
+/* Destroys the channel wrapped by channel, or gives it back to the registry
+ * if it is persistent */
+void grpc_php_release_channel(wrapped_grpc_channel *channel);
+
+/* Watches the connectivity of all the channels at the same time until every
+ * one of them is ready or the deadline passes. Returns the number of ready
+ * channels and sets shutdown if one of them has been shut down */
+int grpc_php_wait_for_channels_ready(grpc_channel **channels, int count,
+                                     gpr_timespec deadline, bool *shutdown);
+
+/* Waits for every channel of objs_count Channel or ChannelPool objects to be
+ * ready. Returns true if they all became ready before the timeout and throws
+ * if one of them is invalid or has been shut down */
+bool grpc_php_wait_for_ready(zval *objs, int objs_count,
+                             zend_long timeout_micros);
+
 /* Iterates through a PHP array and populates args with the contents */
 void php_grpc_read_args_array(zval *args_array, grpc_channel_args *args);
 
@@ -43,6 +43,7 @@
 #include <ext/standard/info.h>
 #include <ext/spl/spl_exceptions.h>
 #include "php_grpc.h"
+#include "credentials_registry.h"
 
 #include <zend_exceptions.h>
 #include <zend_hash.h>
@@ -56,6 +57,9 @@ zend_class_entry *grpc_ce_channel_credentials;
 static zend_object_handlers channel_creds_object_handlers_channel_creds;
 
 static char* default_pem_root_certs = NULL;
+static size_t default_pem_root_certs_length = 0;
+/* Set once core has read the default roots; core then owns the buffer */
+static bool default_pem_root_certs_consumed = false;
 
 static grpc_ssl_roots_override_result get_ssl_roots_override(
     char **pem_root_certs) {
@@ -63,6 +67,7 @@ static grpc_ssl_roots_override_result get_ssl_roots_override(
   if (default_pem_root_certs == NULL) {
     return GRPC_SSL_ROOTS_OVERRIDE_FAIL;
   }
+  default_pem_root_certs_consumed = true;
   return GRPC_SSL_ROOTS_OVERRIDE_OK;
 }
 
@@ -70,7 +75,7 @@ static grpc_ssl_roots_override_result get_ssl_roots_override(
 static void free_wrapped_grpc_channel_credentials(zend_object *object) {
   wrapped_grpc_channel_credentials *creds =
     wrapped_grpc_channel_creds_from_obj(object);
-  if (creds->wrapped != NULL) {
+  if (creds->owned && creds->wrapped != NULL) {
     grpc_channel_credentials_release(creds->wrapped);
   }
   zend_object_std_dtor(&creds->std);
@@ -92,12 +97,16 @@ zend_object *create_wrapped_grpc_channel_credentials(
   return &intern->std;
 }
 
+/* Wraps a grpc_channel_credentials struct in a PHP object. Owned indicates
+   whether the struct should be released at the end of the object's
+   lifecycle */
 void grpc_php_wrap_channel_credentials(grpc_channel_credentials *wrapped,
-                                      zval *credentials_object) {
+                                       bool owned, zval *credentials_object) {
   object_init_ex(credentials_object, grpc_ce_channel_credentials);
   wrapped_grpc_channel_credentials *credentials =
     Z_WRAPPED_GRPC_CHANNEL_CREDS_P(credentials_object);
   credentials->wrapped = wrapped;
+  credentials->owned = owned;
 }
 
  /**
@@ -122,8 +131,27 @@ PHP_METHOD(ChannelCredentials, setDefaultRootsPem) {
   ZEND_PARSE_PARAMETERS_END();
 #endif
 
+  if (default_pem_root_certs != NULL) {
+    /* Core reads the default roots only once and takes ownership of them, so
+     * later updates could never take effect */
+    if (default_pem_root_certs_consumed ||
+        (default_pem_root_certs_length == pem_roots_length &&
+         memcmp(default_pem_root_certs, pem_roots, pem_roots_length) == 0)) {
+      return;
+    }
+    gpr_free(default_pem_root_certs);
+  }
   default_pem_root_certs = gpr_malloc((pem_roots_length + 1) * sizeof(char));
   memcpy(default_pem_root_certs, pem_roots, pem_roots_length + 1);
+  default_pem_root_certs_length = pem_roots_length;
+}
+
+/**
+ * Check whether the default roots pem has already been set in this process.
+ * @return bool True if setDefaultRootsPem has been called before
+ */
+PHP_METHOD(ChannelCredentials, isDefaultRootsPemSet) {
+  RETURN_BOOL(default_pem_root_certs != NULL);
 }
 
 /**
@@ -132,7 +160,7 @@ PHP_METHOD(ChannelCredentials, setDefaultRootsPem) {
  */
 PHP_METHOD(ChannelCredentials, createDefault) {
   grpc_channel_credentials *creds = grpc_google_default_credentials_create();
-  grpc_php_wrap_channel_credentials(creds, return_value);
+  grpc_php_wrap_channel_credentials(creds, true, return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
@@ -178,13 +206,45 @@ PHP_METHOD(ChannelCredentials, createSsl) {
     pem_key_cert_pair.cert_chain = ZSTR_VAL(cert_chain);
   }
 
-  grpc_channel_credentials *creds = grpc_ssl_credentials_create(
+  /* Identical PEM material always yields the same credentials, which are
+   * kept in the process-level registry so that they survive the request */
+  char key[GRPC_PHP_CREDENTIALS_KEY_LENGTH];
+  zend_string *key_parts[] = {pem_root_certs, private_key, cert_chain};
+  grpc_php_credentials_registry_key(GRPC_PHP_CHANNEL_CREDENTIALS, key_parts,
+                                    3, key);
+  grpc_channel_credentials *creds = grpc_php_credentials_registry_find(key);
+  if (creds != NULL) {
+    grpc_php_wrap_channel_credentials(creds, false, return_value);
+    RETURN_DESTROY_ZVAL(return_value);
+  }
+
+  creds = grpc_ssl_credentials_create(
       pem_root_certs == NULL ? NULL : ZSTR_VAL(pem_root_certs),
       pem_key_cert_pair.private_key == NULL ? NULL : &pem_key_cert_pair, NULL);
-  grpc_php_wrap_channel_credentials(creds, return_value);
+  bool registered = grpc_php_credentials_registry_add(
+      key, GRPC_PHP_CHANNEL_CREDENTIALS, creds);
+  grpc_php_wrap_channel_credentials(creds, !registered, return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
+grpc_channel_credentials *grpc_php_default_ssl_channel_credentials() {
+  char key[GRPC_PHP_CREDENTIALS_KEY_LENGTH];
+  zend_string *key_parts[] = {NULL, NULL, NULL};
+  grpc_php_credentials_registry_key(GRPC_PHP_CHANNEL_CREDENTIALS, key_parts,
+                                    3, key);
+  grpc_channel_credentials *creds = grpc_php_credentials_registry_find(key);
+  if (creds != NULL) {
+    return creds;
+  }
+  creds = grpc_ssl_credentials_create(NULL, NULL, NULL);
+  if (!grpc_php_credentials_registry_add(key, GRPC_PHP_CHANNEL_CREDENTIALS,
+                                         creds)) {
+    grpc_channel_credentials_release(creds);
+    return NULL;
+  }
+  return creds;
+}
+
 /**
  * Create composite credentials from two existing credentials.
  * @param ChannelCredentials cred1 The first credential
@@ -218,7 +278,7 @@ PHP_METHOD(ChannelCredentials, createComposite) {
   grpc_channel_credentials *creds =
       grpc_composite_channel_credentials_create(cred1->wrapped,
                                                 cred2->wrapped, NULL);
-  grpc_php_wrap_channel_credentials(creds, return_value);
+  grpc_php_wrap_channel_credentials(creds, true, return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
@@ -233,6 +293,8 @@ PHP_METHOD(ChannelCredentials, createInsecure) {
 static zend_function_entry channel_credentials_methods[] = {
   PHP_ME(ChannelCredentials, setDefaultRootsPem, NULL,
          ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_ME(ChannelCredentials, isDefaultRootsPemSet, NULL,
+         ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
   PHP_ME(ChannelCredentials, createDefault, NULL,
          ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
   PHP_ME(ChannelCredentials, createSsl, NULL,
@@ -52,6 +52,7 @@ extern zend_class_entry *grpc_ce_channel_credentials;
 /* Wrapper struct for grpc_channel_credentials that can be associated
  * with a PHP object */
 typedef struct wrapped_grpc_channel_credentials {
+  bool owned;
   grpc_channel_credentials *wrapped;
   zend_object std;
 } wrapped_grpc_channel_credentials;
@@ -69,4 +70,9 @@ wrapped_grpc_channel_credentials *wrapped_grpc_channel_creds_from_obj(
 /* Initializes the ChannelCredentials PHP class */
 void grpc_init_channel_credentials();
 
+/* Returns the SSL credentials created by ChannelCredentials::createSsl()
+ * without arguments. The credentials registry keeps ownership of them.
+ * Returns NULL if the registry is full */
+grpc_channel_credentials *grpc_php_default_ssl_channel_credentials();
+
 #endif /* NET_GRPC_PHP_GRPC_CHANNEL_CREDENTIALS_H_ */
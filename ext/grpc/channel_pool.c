@@ -0,0 +1,346 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "channel_pool.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include <ext/spl/spl_exceptions.h>
+#include "php_grpc.h"
+
+#include <zend_exceptions.h>
+
+#include <stdbool.h>
+
+#include <grpc/grpc.h>
+#include <grpc/support/alloc.h>
+
+#include "channel.h"
+
+zend_class_entry *grpc_ce_channel_pool;
+
+static zend_object_handlers channel_pool_object_handlers_channel_pool;
+
+/* Releases the Channel objects of a pool */
+static void destroy_channel_pool_channels(wrapped_grpc_channel_pool *pool) {
+  zend_long i;
+  if (pool->channels == NULL) {
+    return;
+  }
+  for (i = 0; i < pool->size; i++) {
+    zval_ptr_dtor(&pool->channels[i]);
+  }
+  efree(pool->channels);
+  pool->channels = NULL;
+  pool->size = 0;
+}
+
+/* Frees and destroys an instance of wrapped_grpc_channel_pool */
+static void free_wrapped_grpc_channel_pool(zend_object *object) {
+  wrapped_grpc_channel_pool *pool = wrapped_grpc_channel_pool_from_obj(object);
+  destroy_channel_pool_channels(pool);
+  zend_object_std_dtor(&pool->std);
+}
+
+/* Initializes an instance of wrapped_grpc_channel_pool to be associated with
+ * an object of a class specified by class_type */
+zend_object *create_wrapped_grpc_channel_pool(zend_class_entry *class_type) {
+  wrapped_grpc_channel_pool *intern;
+  intern = ecalloc(1, sizeof(wrapped_grpc_channel_pool) +
+                   zend_object_properties_size(class_type));
+
+  zend_object_std_init(&intern->std, class_type);
+  object_properties_init(&intern->std, class_type);
+
+  intern->std.handlers = &channel_pool_object_handlers_channel_pool;
+
+  return &intern->std;
+}
+
+zval *grpc_php_channel_pool_pick(wrapped_grpc_channel_pool *pool) {
+  zval *best = NULL;
+  zend_long best_in_flight = 0;
+  zend_long i;
+  for (i = 0; i < pool->size; i++) {
+    wrapped_grpc_channel *channel =
+      Z_WRAPPED_GRPC_CHANNEL_P(&pool->channels[i]);
+    if (channel->wrapped == NULL) {
+      continue;
+    }
+    if (best == NULL || channel->in_flight < best_in_flight) {
+      best = &pool->channels[i];
+      best_in_flight = channel->in_flight;
+    }
+  }
+  return best;
+}
+
+/**
+ * Construct an instance of the ChannelPool class. The pool keeps $size
+ * channels to the same target, each with its own connection, and new calls
+ * are started on the channel with the fewest calls in flight.
+ * @param string $target The hostname to associate with the channels
+ * @param array $args The arguments to pass to every Channel
+ * @param long $size The number of channels in the pool
+ */
+PHP_METHOD(ChannelPool, __construct) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zend_string *target;
+  zval *args_array = NULL;
+  zend_long size;
+  zend_long i;
+
+  /* "Sal" == 1 string, 1 array, 1 long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "Sal", &target, &args_array,
+                            &size) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "ChannelPool expects a string, an array and a long",
+                         1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(3, 3)
+    Z_PARAM_STR(target)
+    Z_PARAM_ARRAY(args_array)
+    Z_PARAM_LONG(size)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (size < 1) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "ChannelPool size must be positive", 1);
+    return;
+  }
+
+  destroy_channel_pool_channels(pool);
+  pool->channels = ecalloc(size, sizeof(zval));
+  for (i = 0; i < size; i++) {
+    zval args_copy;
+    ZVAL_ARR(&args_copy, zend_array_dup(Z_ARRVAL_P(args_array)));
+    add_assoc_long(&args_copy, GRPC_PHP_CHANNEL_POOL_INDEX_ARG, i);
+    object_init_ex(&pool->channels[i], grpc_ce_channel);
+    pool->size = i + 1;
+    grpc_php_channel_init(Z_WRAPPED_GRPC_CHANNEL_P(&pool->channels[i]),
+                          target, &args_copy);
+    zval_ptr_dtor(&args_copy);
+    if (EG(exception)) {
+      return;
+    }
+  }
+}
+
+/**
+ * Get the channel that the next call should be started on
+ * @return Channel The open channel with the fewest calls in flight
+ */
+PHP_METHOD(ChannelPool, getChannel) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zval *channel = grpc_php_channel_pool_pick(pool);
+  if (channel == NULL) {
+    zend_throw_exception(spl_ce_LogicException,
+                         "ChannelPool has been closed", 1);
+    return;
+  }
+  RETURN_ZVAL(channel, 1, 0);
+}
+
+/**
+ * Get all the channels of the pool
+ * @return array The Channel objects of the pool
+ */
+PHP_METHOD(ChannelPool, getChannels) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zend_long i;
+  array_init_size(return_value, (uint32_t)pool->size);
+  for (i = 0; i < pool->size; i++) {
+    Z_ADDREF(pool->channels[i]);
+    add_next_index_zval(return_value, &pool->channels[i]);
+  }
+}
+
+/**
+ * Get the number of channels in the pool
+ * @return long The size of the pool
+ */
+PHP_METHOD(ChannelPool, getSize) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  RETURN_LONG(pool->size);
+}
+
+/**
+ * Get the number of calls in flight over all the channels of the pool
+ * @return long The number of calls that have not completed yet
+ */
+PHP_METHOD(ChannelPool, getInFlight) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zend_long in_flight = 0;
+  zend_long i;
+  for (i = 0; i < pool->size; i++) {
+    in_flight += Z_WRAPPED_GRPC_CHANNEL_P(&pool->channels[i])->in_flight;
+  }
+  RETURN_LONG(in_flight);
+}
+
+/**
+ * Get the endpoint the channels of the pool are connected to
+ * @return string The URI of the endpoint
+ */
+PHP_METHOD(ChannelPool, getTarget) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zval *channel = grpc_php_channel_pool_pick(pool);
+  if (channel == NULL) {
+    zend_throw_exception(spl_ce_LogicException,
+                         "ChannelPool has been closed", 1);
+    return;
+  }
+  char *target = grpc_channel_get_target(
+      Z_WRAPPED_GRPC_CHANNEL_P(channel)->wrapped);
+  RETVAL_STRING(target);
+  gpr_free(target);
+}
+
+/**
+ * Get the connectivity state of the pool
+ * @param bool (optional) try to connect on every channel
+ * @return long CHANNEL_READY if all the channels are ready, or else the
+ *     state of the first channel that is not
+ */
+PHP_METHOD(ChannelPool, getConnectivityState) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zend_bool try_to_connect = 0;
+  grpc_connectivity_state state;
+  grpc_connectivity_state result = GRPC_CHANNEL_READY;
+  zend_long i;
+
+  /* "|b" == 1 optional bool */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|b",
+                            &try_to_connect) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "getConnectivityState expects a bool", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(0, 1)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_BOOL(try_to_connect)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  for (i = 0; i < pool->size; i++) {
+    wrapped_grpc_channel *channel =
+      Z_WRAPPED_GRPC_CHANNEL_P(&pool->channels[i]);
+    if (channel->wrapped == NULL) {
+      state = GRPC_CHANNEL_SHUTDOWN;
+    } else {
+      state = grpc_channel_check_connectivity_state(channel->wrapped,
+                                                    (int)try_to_connect);
+    }
+    if (result == GRPC_CHANNEL_READY) {
+      result = state;
+    }
+  }
+  RETURN_LONG(result);
+}
+
+/**
+ * Try to connect every channel of the pool and wait until they are all ready
+ * @param long $timeout The time in microseconds to wait for the channels
+ * @return bool True if all the channels became ready before the timeout
+ * @throw Exception if the pool has been closed
+ */
+PHP_METHOD(ChannelPool, waitForReady) {
+  zend_long timeout;
+
+  /* "l" == 1 long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &timeout) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "waitForReady expects a long", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_LONG(timeout)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  RETURN_BOOL(grpc_php_wait_for_ready(getThis(), 1, timeout));
+}
+
+/**
+ * Close every channel of the pool
+ */
+PHP_METHOD(ChannelPool, close) {
+  wrapped_grpc_channel_pool *pool = Z_WRAPPED_GRPC_CHANNEL_POOL_P(getThis());
+  zend_long i;
+  for (i = 0; i < pool->size; i++) {
+    wrapped_grpc_channel *channel =
+      Z_WRAPPED_GRPC_CHANNEL_P(&pool->channels[i]);
+    if (channel->wrapped != NULL) {
+      grpc_php_release_channel(channel);
+    }
+  }
+}
+
+static zend_function_entry channel_pool_methods[] = {
+    PHP_ME(ChannelPool, __construct, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
+    PHP_ME(ChannelPool, getChannel, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, getChannels, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, getSize, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, getInFlight, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, getTarget, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, getConnectivityState, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, waitForReady, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(ChannelPool, close, NULL, ZEND_ACC_PUBLIC)
+    PHP_FE_END
+};
+
+void grpc_init_channel_pool() {
+  zend_class_entry ce;
+  INIT_CLASS_ENTRY(ce, "Grpc\\ChannelPool", channel_pool_methods);
+  ce.create_object = create_wrapped_grpc_channel_pool;
+  grpc_ce_channel_pool = zend_register_internal_class(&ce);
+  memcpy(&channel_pool_object_handlers_channel_pool,
+         zend_get_std_object_handlers(), sizeof(zend_object_handlers));
+  channel_pool_object_handlers_channel_pool.offset =
+    XtOffsetOf(wrapped_grpc_channel_pool, std);
+  channel_pool_object_handlers_channel_pool.free_obj =
+    free_wrapped_grpc_channel_pool;
+}
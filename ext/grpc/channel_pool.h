@@ -0,0 +1,80 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_CHANNEL_POOL_H_
+#define NET_GRPC_PHP_GRPC_CHANNEL_POOL_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include "php_grpc.h"
+
+#include <grpc/grpc.h>
+
+/* Channel arg that makes the sub-channels of a pool distinct, so that core
+ * does not share one connection between them */
+#define GRPC_PHP_CHANNEL_POOL_INDEX_ARG "grpc.php_channel_pool_index"
+
+/* Class entry for the PHP ChannelPool class */
+extern zend_class_entry *grpc_ce_channel_pool;
+
+/* Wrapper struct for a set of Channel objects to the same target that can be
+ * associated with a PHP object */
+typedef struct wrapped_grpc_channel_pool {
+  /* Channel objects of the pool */
+  zval *channels;
+  zend_long size;
+  zend_object std;
+} wrapped_grpc_channel_pool;
+
+static inline wrapped_grpc_channel_pool *wrapped_grpc_channel_pool_from_obj(
+    zend_object *obj) {
+    return (wrapped_grpc_channel_pool*)(
+        (char*)(obj) - XtOffsetOf(wrapped_grpc_channel_pool, std));
+}
+
+#define Z_WRAPPED_GRPC_CHANNEL_POOL_P(zv) \
+        wrapped_grpc_channel_pool_from_obj(Z_OBJ_P((zv)))
+
+/* Initializes the ChannelPool class */
+void grpc_init_channel_pool();
+
+/* Returns the Channel object of the pool with the fewest calls in flight, or
+ * NULL if the pool has been closed */
+zval *grpc_php_channel_pool_pick(wrapped_grpc_channel_pool *pool);
+
+#endif /* NET_GRPC_PHP_GRPC_CHANNEL_POOL_H_ */
@@ -4,6 +4,9 @@ PHP_ARG_ENABLE(grpc, whether to enable grpc support,
 PHP_ARG_ENABLE(coverage, whether to include code coverage symbols,
 [  --enable-coverage       Enable coverage support], no, no)
 
+PHP_ARG_ENABLE(grpc-bench, whether to include the benchmark class,
+[  --enable-grpc-bench     Enable the microbenchmarks of make bench], no, no)
+
 PHP_ARG_WITH(grpc, for grpc support,
 Make sure that the comment is aligned:
 [  --with-grpc             Include grpc support ])
@@ -76,11 +79,23 @@ if test "$PHP_GRPC" != "no"; then
     -L$GRPC_LIBDIR
   ])
 
+  dnl USDT probes, see probes.h
+  AC_CHECK_HEADERS([sys/sdt.h])
+
+  GRPC_BENCH_SOURCES=
+  if test "$PHP_GRPC_BENCH" != "no"; then
+    AC_DEFINE(GRPC_PHP_BENCH,1,[Whether to include the benchmark class])
+    GRPC_BENCH_SOURCES=bench.c
+  fi
+
   PHP_SUBST(GRPC_SHARED_LIBADD)
 
-  PHP_NEW_EXTENSION(grpc, byte_buffer.c call.c call_credentials.c channel.c \
-    channel_credentials.c completion_queue.c timeval.c server.c \
-    server_credentials.c php_grpc.c, $ext_shared, , -Wall -Werror -std=c11)
+  PHP_NEW_EXTENSION(grpc, batch_template.c byte_buffer.c call.c \
+    call_credentials.c channel.c channel_credentials.c channel_pool.c \
+    completion_queue.c credentials_registry.c metadata.c metrics.c timeval.c \
+    server.c server_credentials.c slow_call_log.c stats.c php_grpc.c \
+    $GRPC_BENCH_SOURCES, $ext_shared, , -Wall -Werror -std=c11)
+  PHP_ADD_MAKEFILE_FRAGMENT([$ext_srcdir/Makefile.bench.frag])
 fi
 
 if test "$PHP_COVERAGE" = "yes"; then
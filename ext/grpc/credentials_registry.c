@@ -0,0 +1,143 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "credentials_registry.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <ext/standard/sha1.h>
+#include "php_grpc.h"
+
+#include <zend_hash.h>
+
+#include <grpc/grpc.h>
+#include <grpc/grpc_security.h>
+#include <grpc/support/sync.h>
+
+/* Entry of the registry; lives for the lifetime of the process */
+typedef struct registry_entry {
+  grpc_php_credentials_type type;
+  void *creds;
+} registry_entry;
+
+static HashTable registry;
+static gpr_mu registry_mu;
+
+static void free_registry_entry(zval *data) {
+  registry_entry *entry = (registry_entry *)Z_PTR_P(data);
+  switch (entry->type) {
+    case GRPC_PHP_CHANNEL_CREDENTIALS:
+      grpc_channel_credentials_release(
+          (grpc_channel_credentials *)entry->creds);
+      break;
+    case GRPC_PHP_SERVER_CREDENTIALS:
+      grpc_server_credentials_release((grpc_server_credentials *)entry->creds);
+      break;
+  }
+  pefree(entry, 1);
+}
+
+void grpc_php_init_credentials_registry() {
+  zend_hash_init(&registry, GRPC_PHP_CREDENTIALS_REGISTRY_SIZE, NULL,
+                 free_registry_entry, 1);
+  gpr_mu_init(&registry_mu);
+}
+
+void grpc_php_shutdown_credentials_registry() {
+  zend_hash_destroy(&registry);
+  gpr_mu_destroy(&registry_mu);
+}
+
+void grpc_php_credentials_registry_key(grpc_php_credentials_type type,
+                                       zend_string **parts, int parts_count,
+                                       char *key) {
+  PHP_SHA1_CTX context;
+  unsigned char digest[20];
+  unsigned char type_byte = (unsigned char)type;
+  int i;
+
+  PHP_SHA1Init(&context);
+  PHP_SHA1Update(&context, &type_byte, 1);
+  for (i = 0; i < parts_count; i++) {
+    /* Prefix every part with its length so that the boundaries between
+     * parts are part of the digest; -1 marks a missing part */
+    zend_long length = parts[i] == NULL ? -1 : (zend_long)ZSTR_LEN(parts[i]);
+    PHP_SHA1Update(&context, (unsigned char *)&length, sizeof(length));
+    if (parts[i] != NULL) {
+      PHP_SHA1Update(&context, (unsigned char *)ZSTR_VAL(parts[i]),
+                     ZSTR_LEN(parts[i]));
+    }
+  }
+  PHP_SHA1Final(digest, &context);
+  make_sha1_digest(key, digest);
+}
+
+void *grpc_php_credentials_registry_find(const char *key) {
+  registry_entry *entry;
+  gpr_mu_lock(&registry_mu);
+  entry = zend_hash_str_find_ptr(&registry, key,
+                                 GRPC_PHP_CREDENTIALS_KEY_LENGTH - 1);
+  gpr_mu_unlock(&registry_mu);
+  return entry == NULL ? NULL : entry->creds;
+}
+
+bool grpc_php_credentials_registry_add(const char *key,
+                                       grpc_php_credentials_type type,
+                                       void *creds) {
+  registry_entry *entry;
+  bool added = false;
+  gpr_mu_lock(&registry_mu);
+  if (zend_hash_num_elements(&registry) < GRPC_PHP_CREDENTIALS_REGISTRY_SIZE &&
+      !zend_hash_str_exists(&registry, key,
+                            GRPC_PHP_CREDENTIALS_KEY_LENGTH - 1)) {
+    entry = pemalloc(sizeof(registry_entry), 1);
+    entry->type = type;
+    entry->creds = creds;
+    zend_hash_str_add_ptr(&registry, key, GRPC_PHP_CREDENTIALS_KEY_LENGTH - 1,
+                          entry);
+    added = true;
+  }
+  gpr_mu_unlock(&registry_mu);
+  return added;
+}
+
+int grpc_php_credentials_registry_count() {
+  int count;
+  gpr_mu_lock(&registry_mu);
+  count = zend_hash_num_elements(&registry);
+  gpr_mu_unlock(&registry_mu);
+  return count;
+}
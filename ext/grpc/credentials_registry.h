@@ -0,0 +1,87 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_CREDENTIALS_REGISTRY_H_
+#define NET_GRPC_PHP_GRPC_CREDENTIALS_REGISTRY_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include "php_grpc.h"
+
+#include <stdbool.h>
+
+#include <grpc/grpc.h>
+#include <grpc/grpc_security.h>
+
+/* Length of a registry key: a hex encoded SHA-1 digest plus the terminator */
+#define GRPC_PHP_CREDENTIALS_KEY_LENGTH 41
+
+/* Maximum number of credentials objects kept by the registry */
+#define GRPC_PHP_CREDENTIALS_REGISTRY_SIZE 64
+
+/* Kinds of credentials kept by the registry */
+typedef enum {
+  GRPC_PHP_CHANNEL_CREDENTIALS,
+  GRPC_PHP_SERVER_CREDENTIALS
+} grpc_php_credentials_type;
+
+/* Initializes the process-level credentials registry */
+void grpc_php_init_credentials_registry();
+
+/* Releases every credentials object held by the registry */
+void grpc_php_shutdown_credentials_registry();
+
+/* Computes the registry key of a credentials object of the given type built
+ * from parts_count PEM strings. NULL parts are allowed and distinct from
+ * empty strings */
+void grpc_php_credentials_registry_key(grpc_php_credentials_type type,
+                                       zend_string **parts, int parts_count,
+                                       char *key);
+
+/* Returns the credentials registered under key, or NULL. The registry keeps
+ * ownership of the returned credentials */
+void *grpc_php_credentials_registry_find(const char *key);
+
+/* Registers creds under key. On success the registry takes ownership of creds
+ * and true is returned; on failure the caller keeps ownership */
+bool grpc_php_credentials_registry_add(const char *key,
+                                       grpc_php_credentials_type type,
+                                       void *creds);
+
+/* Returns the number of credentials objects held by the registry */
+int grpc_php_credentials_registry_count();
+
+#endif /* NET_GRPC_PHP_GRPC_CREDENTIALS_REGISTRY_H_ */
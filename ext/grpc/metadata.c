@@ -0,0 +1,239 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "metadata.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include <ext/spl/spl_exceptions.h>
+#include "php_grpc.h"
+
+#include <zend_exceptions.h>
+
+#include <stdbool.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+zend_class_entry *grpc_ce_metadata;
+
+/* Keys up to this length are lowercased on the stack */
+#define KEY_BUFFER_SIZE 64
+
+#ifdef __SSE2__
+/* Returns a mask of the bytes of v in [lo, hi]. Bytes above 0x7f compare as
+ * negative, so they are never in range */
+static inline __m128i bytes_in_range(__m128i v, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8(lo - 1)),
+                       _mm_cmplt_epi8(v, _mm_set1_epi8(hi + 1)));
+}
+#endif
+
+/* Checks that the len bytes of key are legal metadata key characters,
+ * [A-Za-z0-9_.-], and writes them lowercased to out. Returns -1 on an
+ * illegal character, else whether any character was uppercase */
+static int normalize_key(const char *key, size_t len, char *out) {
+  size_t i = 0;
+  int upper_seen = 0;
+  unsigned char c;
+#ifdef __SSE2__
+  __m128i v, upper, valid;
+
+  for (; i + 16 <= len; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(key + i));
+    upper = bytes_in_range(v, 'A', 'Z');
+    valid = _mm_or_si128(upper, bytes_in_range(v, 'a', 'z'));
+    valid = _mm_or_si128(valid, bytes_in_range(v, '0', '9'));
+    valid = _mm_or_si128(valid, _mm_cmpeq_epi8(v, _mm_set1_epi8('-')));
+    valid = _mm_or_si128(valid, _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+    valid = _mm_or_si128(valid, _mm_cmpeq_epi8(v, _mm_set1_epi8('.')));
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+      return -1;
+    }
+    upper_seen |= _mm_movemask_epi8(upper);
+    v = _mm_add_epi8(v, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+    _mm_storeu_si128((__m128i *)(out + i), v);
+  }
+#endif
+  for (; i < len; i++) {
+    c = (unsigned char)key[i];
+    if (c >= 'A' && c <= 'Z') {
+      out[i] = c + ('a' - 'A');
+      upper_seen = 1;
+    } else if ((c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') ||
+               c == '-' || c == '_' || c == '.') {
+      out[i] = c;
+    } else {
+      return -1;
+    }
+  }
+  return upper_seen != 0;
+}
+
+/* Checks that the len bytes of a value of a non binary key are printable
+ * ASCII characters */
+static bool value_is_legal(const char *value, size_t len) {
+  size_t i = 0;
+  unsigned char c;
+#ifdef __SSE2__
+  __m128i v;
+
+  for (; i + 16 <= len; i += 16) {
+    v = _mm_loadu_si128((const __m128i *)(value + i));
+    if (_mm_movemask_epi8(bytes_in_range(v, 0x20, 0x7e)) != 0xffff) {
+      return false;
+    }
+  }
+#endif
+  for (; i < len; i++) {
+    c = (unsigned char)value[i];
+    if (c < 0x20 || c > 0x7e) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/* Returns whether a metadata key names a binary header */
+static inline bool key_is_binary(const char *key, size_t len) {
+  return len > 4 && memcmp(key + len - 4, "-bin", 4) == 0;
+}
+
+/**
+ * Validate a metadata map and lowercase its keys, in a single pass over
+ * each key. Keys must be nonempty and contain only alphanumeric characters,
+ * hyphens, underscores and periods. Values must be arrays of strings, which
+ * are printable ASCII unless the key ends in "-bin"; binary values are sent
+ * as they are and encoded by the transport.
+ * @param array $metadata The metadata map
+ * @return array The metadata map with lowercase keys
+ */
+PHP_METHOD(Metadata, normalize) {
+  zval *metadata;
+  zend_string *key;
+  zend_string *normalized;
+  zval *values;
+  zval *value;
+  char buffer[KEY_BUFFER_SIZE];
+  char *out;
+  int upper_seen;
+  bool binary;
+
+  /* "a" == 1 array */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "a", &metadata) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "normalize expects a metadata array", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_ARRAY(metadata)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  array_init_size(return_value, zend_hash_num_elements(Z_ARRVAL_P(metadata)));
+  ZEND_HASH_FOREACH_STR_KEY_VAL(Z_ARRVAL_P(metadata), key, values) {
+    if (key == NULL || ZSTR_LEN(key) == 0) {
+      goto invalid_key;
+    }
+    out = ZSTR_LEN(key) <= KEY_BUFFER_SIZE ?
+        buffer : emalloc(ZSTR_LEN(key));
+    upper_seen = normalize_key(ZSTR_VAL(key), ZSTR_LEN(key), out);
+    if (upper_seen > 0) {
+      normalized = zend_string_init(out, ZSTR_LEN(key), 0);
+    } else {
+      normalized = zend_string_copy(key);
+    }
+    if (out != buffer) {
+      efree(out);
+    }
+    if (upper_seen < 0) {
+      zend_string_release(normalized);
+      goto invalid_key;
+    }
+
+    ZVAL_DEREF(values);
+    if (Z_TYPE_P(values) != IS_ARRAY) {
+      zend_string_release(normalized);
+      goto invalid_value;
+    }
+    binary = key_is_binary(ZSTR_VAL(normalized), ZSTR_LEN(normalized));
+    ZEND_HASH_FOREACH_VAL(Z_ARRVAL_P(values), value) {
+      ZVAL_DEREF(value);
+      if (Z_TYPE_P(value) != IS_STRING ||
+          (!binary && !value_is_legal(Z_STRVAL_P(value),
+                                      Z_STRLEN_P(value)))) {
+        zend_string_release(normalized);
+        goto invalid_value;
+      }
+    } ZEND_HASH_FOREACH_END();
+
+    Z_TRY_ADDREF_P(values);
+    zend_symtable_update(Z_ARRVAL_P(return_value), normalized, values);
+    zend_string_release(normalized);
+  } ZEND_HASH_FOREACH_END();
+  return;
+
+invalid_key:
+  zval_dtor(return_value);
+  zend_throw_exception(spl_ce_InvalidArgumentException,
+                       "Metadata keys must be nonempty strings containing "
+                       "only alphanumeric characters, hyphens, underscores "
+                       "and periods", 1);
+  RETURN_NULL();
+
+invalid_value:
+  zval_dtor(return_value);
+  zend_throw_exception(spl_ce_InvalidArgumentException,
+                       "Metadata values must be arrays of printable ASCII "
+                       "strings, or of any strings for -bin keys", 1);
+  RETURN_NULL();
+}
+
+static zend_function_entry metadata_methods[] = {
+  PHP_ME(Metadata, normalize, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_FE_END
+};
+
+void grpc_init_metadata() {
+  zend_class_entry ce;
+  INIT_CLASS_ENTRY(ce, "Grpc\\Metadata", metadata_methods);
+  grpc_ce_metadata = zend_register_internal_class(&ce);
+}
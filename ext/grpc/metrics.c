@@ -0,0 +1,375 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "metrics.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include "php_grpc.h"
+
+#include <zend_smart_str.h>
+
+#include <stdbool.h>
+
+#ifndef PHP_WIN32
+#include <sys/mman.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+zend_class_entry *grpc_ce_metrics;
+
+/* States of a method slot */
+#define SLOT_FREE 0
+#define SLOT_CLAIMED 1
+#define SLOT_READY 2
+#define SLOT_DEAD 3
+
+/* How long a process waits for another one to finish claiming a slot before
+ * marking it dead, which only happens if the other process died or was
+ * descheduled meanwhile. A claim only copies the method name */
+#define CLAIM_SPINS 1000
+
+/* The method slots, followed by the slot of the calls to methods that did
+ * not get a slot of their own */
+static grpc_php_method_metrics *slots = NULL;
+static size_t slot_count = 0;
+static size_t segment_size = 0;
+
+/* Upper bounds in microseconds of the latency buckets exported for
+ * Prometheus, which are coarser than the ones of the histogram */
+static const uint64_t export_bounds_us[] = {
+  1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+  1000000, 2500000, 5000000, 10000000
+};
+
+#define EXPORT_BUCKETS \
+  (sizeof(export_bounds_us) / sizeof(export_bounds_us[0]))
+
+/* The canonical names of the status codes */
+static const char *status_names[GRPC_PHP_STATUS_CODES] = {
+  "OK", "CANCELLED", "UNKNOWN", "INVALID_ARGUMENT", "DEADLINE_EXCEEDED",
+  "NOT_FOUND", "ALREADY_EXISTS", "PERMISSION_DENIED", "RESOURCE_EXHAUSTED",
+  "FAILED_PRECONDITION", "ABORTED", "OUT_OF_RANGE", "UNIMPLEMENTED",
+  "INTERNAL", "UNAVAILABLE", "DATA_LOSS", "UNAUTHENTICATED"
+};
+
+/* Waits for a slot being claimed by another process to hold a method.
+ * Returns false if the slot is dead, or if the claim does not complete in
+ * time, in which case the slot is marked dead so that no process waits for
+ * it again */
+static bool wait_for_slot(grpc_php_method_metrics *slot) {
+  gpr_atm state;
+  int spins;
+  for (spins = 0; spins < CLAIM_SPINS; spins++) {
+    state = gpr_atm_acq_load(&slot->state);
+    if (state == SLOT_READY) {
+      return true;
+    }
+    if (state == SLOT_DEAD) {
+      return false;
+    }
+  }
+  gpr_atm_rel_cas(&slot->state, SLOT_CLAIMED, SLOT_DEAD);
+  return gpr_atm_acq_load(&slot->state) == SLOT_READY;
+}
+
+grpc_php_call_stats *grpc_php_method_metrics_find(const char *method,
+                                                  size_t method_len) {
+  grpc_php_method_metrics *slot;
+  zend_ulong hash;
+  size_t i;
+  if (slots == NULL) {
+    return NULL;
+  }
+  if (method_len >= GRPC_PHP_METRICS_METHOD_LENGTH) {
+    method_len = GRPC_PHP_METRICS_METHOD_LENGTH - 1;
+  }
+  /* The hash has to be the same in every process */
+  hash = zend_inline_hash_func(method, method_len);
+  for (i = 0; i < slot_count; i++) {
+    slot = &slots[(hash + i) % slot_count];
+    if (gpr_atm_acq_load(&slot->state) == SLOT_FREE &&
+        gpr_atm_acq_cas(&slot->state, SLOT_FREE, SLOT_CLAIMED)) {
+      memcpy(slot->method, method, method_len);
+      slot->method[method_len] = '\0';
+      /* Another process that gave up on a slow claim has moved on to the
+       * next slots, where this one follows it */
+      if (gpr_atm_rel_cas(&slot->state, SLOT_CLAIMED, SLOT_READY)) {
+        return &slot->stats;
+      }
+      continue;
+    }
+    if (!wait_for_slot(slot)) {
+      continue;
+    }
+    if (strncmp(slot->method, method, method_len) == 0 &&
+        slot->method[method_len] == '\0') {
+      return &slot->stats;
+    }
+  }
+  return &slots[slot_count].stats;
+}
+
+/* Appends a Prometheus label value, escaped */
+static void append_label_value(smart_str *out, const char *value) {
+  for (; *value != '\0'; value++) {
+    switch (*value) {
+      case '\\':
+        smart_str_appendl(out, "\\\\", 2);
+        break;
+      case '"':
+        smart_str_appendl(out, "\\\"", 2);
+        break;
+      case '\n':
+        smart_str_appendl(out, "\\n", 2);
+        break;
+      default:
+        smart_str_appendc(out, *value);
+    }
+  }
+}
+
+/* Appends a sample of a metric for a method, with an optional extra label */
+static void append_sample(smart_str *out, const char *metric,
+                          const char *method, const char *label,
+                          const char *label_value, zend_long value) {
+  smart_str_appends(out, metric);
+  smart_str_appends(out, "{method=\"");
+  append_label_value(out, method);
+  smart_str_appendc(out, '"');
+  if (label != NULL) {
+    smart_str_appendc(out, ',');
+    smart_str_appends(out, label);
+    smart_str_appends(out, "=\"");
+    smart_str_appends(out, label_value);
+    smart_str_appendc(out, '"');
+  }
+  smart_str_appends(out, "} ");
+  smart_str_append_long(out, value);
+  smart_str_appendc(out, '\n');
+}
+
+/* Appends the latency histogram of a method */
+static void append_histogram(smart_str *out, const char *method,
+                             grpc_php_call_stats *stats) {
+  char le[32];
+  char sum[32];
+  size_t i;
+  int bucket = 0;
+  gpr_atm count = 0;
+  for (i = 0; i < EXPORT_BUCKETS; i++) {
+    while (bucket < GRPC_PHP_LATENCY_BUCKETS &&
+           grpc_php_latency_bucket_upper_bound(bucket) <=
+           export_bounds_us[i]) {
+      count += gpr_atm_no_barrier_load(&stats->latency_buckets[bucket]);
+      bucket++;
+    }
+    snprintf(le, sizeof(le), "%g", (double)export_bounds_us[i] / 1e6);
+    append_sample(out, "grpc_client_call_duration_seconds_bucket", method,
+                  "le", le, count);
+  }
+  for (; bucket < GRPC_PHP_LATENCY_BUCKETS; bucket++) {
+    count += gpr_atm_no_barrier_load(&stats->latency_buckets[bucket]);
+  }
+  append_sample(out, "grpc_client_call_duration_seconds_bucket", method,
+                "le", "+Inf", count);
+  append_sample(out, "grpc_client_call_duration_seconds_count", method,
+                NULL, NULL, count);
+  smart_str_appends(out, "grpc_client_call_duration_seconds_sum{method=\"");
+  append_label_value(out, method);
+  snprintf(sum, sizeof(sum), "\"} %.6f\n",
+           (double)gpr_atm_no_barrier_load(&stats->latency_sum_us) / 1e6);
+  smart_str_appends(out, sum);
+}
+
+/* Appends the HELP and TYPE lines of a metric */
+static void append_header(smart_str *out, const char *metric,
+                          const char *type, const char *help) {
+  smart_str_appends(out, "# HELP ");
+  smart_str_appends(out, metric);
+  smart_str_appendc(out, ' ');
+  smart_str_appends(out, help);
+  smart_str_appends(out, "\n# TYPE ");
+  smart_str_appends(out, metric);
+  smart_str_appendc(out, ' ');
+  smart_str_appends(out, type);
+  smart_str_appendc(out, '\n');
+}
+
+/* Returns the method counted by slot i, or NULL if the slot is unused. The
+ * last slot counts the calls to methods that did not get a slot */
+static const char *slot_method(size_t i) {
+  if (i == slot_count) {
+    return gpr_atm_no_barrier_load(&slots[i].stats.calls_started) > 0 ?
+        "__other__" : NULL;
+  }
+  return gpr_atm_acq_load(&slots[i].state) == SLOT_READY ?
+      slots[i].method : NULL;
+}
+
+/**
+ * Render the call metrics of all the processes sharing the metrics segment,
+ * by method, in the Prometheus text exposition format. Returns an empty
+ * string unless grpc.metrics is enabled.
+ * @return string The metrics
+ */
+PHP_METHOD(Metrics, export) {
+  smart_str out = {0};
+  grpc_php_call_stats *stats;
+  const char *method;
+  int status;
+  gpr_atm calls;
+  size_t i;
+
+  if (zend_parse_parameters_none() == FAILURE) {
+    return;
+  }
+  if (slots == NULL) {
+    RETURN_EMPTY_STRING();
+  }
+
+  append_header(&out, "grpc_client_started_total", "counter",
+                "Client calls started.");
+  for (i = 0; i <= slot_count; i++) {
+    if ((method = slot_method(i)) != NULL) {
+      append_sample(&out, "grpc_client_started_total", method, NULL, NULL,
+                    gpr_atm_no_barrier_load(&slots[i].stats.calls_started));
+    }
+  }
+  append_header(&out, "grpc_client_handled_total", "counter",
+                "Client calls completed, by status code.");
+  for (i = 0; i <= slot_count; i++) {
+    if ((method = slot_method(i)) == NULL) {
+      continue;
+    }
+    stats = &slots[i].stats;
+    for (status = 0; status < GRPC_PHP_STATUS_CODES; status++) {
+      calls = gpr_atm_no_barrier_load(&stats->calls_by_status[status]);
+      if (calls > 0) {
+        append_sample(&out, "grpc_client_handled_total", method, "code",
+                      status_names[status], calls);
+      }
+    }
+  }
+  append_header(&out, "grpc_client_sent_bytes_total", "counter",
+                "Bytes of messages sent by client calls.");
+  for (i = 0; i <= slot_count; i++) {
+    if ((method = slot_method(i)) != NULL) {
+      append_sample(&out, "grpc_client_sent_bytes_total", method, NULL, NULL,
+                    gpr_atm_no_barrier_load(&slots[i].stats.bytes_sent));
+    }
+  }
+  append_header(&out, "grpc_client_received_bytes_total", "counter",
+                "Bytes of messages received by client calls.");
+  for (i = 0; i <= slot_count; i++) {
+    if ((method = slot_method(i)) != NULL) {
+      append_sample(&out, "grpc_client_received_bytes_total", method, NULL,
+                    NULL,
+                    gpr_atm_no_barrier_load(&slots[i].stats.bytes_received));
+    }
+  }
+  append_header(&out, "grpc_client_call_duration_seconds", "histogram",
+                "Latency of completed client calls.");
+  for (i = 0; i <= slot_count; i++) {
+    if ((method = slot_method(i)) != NULL) {
+      append_histogram(&out, method, &slots[i].stats);
+    }
+  }
+
+  smart_str_0(&out);
+  RETURN_NEW_STR(out.s);
+}
+
+static zend_function_entry metrics_methods[] = {
+  PHP_ME(Metrics, export, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+  PHP_FE_END
+};
+
+void grpc_init_metrics() {
+  zend_class_entry ce;
+  INIT_CLASS_ENTRY(ce, "Grpc\\Metrics", metrics_methods);
+  grpc_ce_metrics = zend_register_internal_class(&ce);
+
+#ifdef MAP_ANONYMOUS
+  void *segment;
+  if (!GRPC_G(metrics) || GRPC_G(metrics_max_methods) <= 0) {
+    return;
+  }
+  slot_count = (size_t)GRPC_G(metrics_max_methods);
+  segment_size = (slot_count + 1) * sizeof(grpc_php_method_metrics);
+  /* Anonymous shared pages are zeroed, so every slot starts free */
+  segment = mmap(NULL, segment_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (segment == MAP_FAILED) {
+    php_error_docref(NULL, E_WARNING,
+                     "grpc.metrics: cannot map the shared metrics segment");
+    slot_count = 0;
+    return;
+  }
+  slots = segment;
+#endif
+}
+
+void grpc_shutdown_metrics() {
+#ifdef MAP_ANONYMOUS
+  if (slots != NULL) {
+    munmap(slots, segment_size);
+    slots = NULL;
+    slot_count = 0;
+  }
+#endif
+}
+
+void grpc_minfo_metrics() {
+  char buf[64];
+  size_t used = 0;
+  size_t i;
+  if (slots == NULL) {
+    php_info_print_table_row(2, "Shared metrics", "disabled");
+    return;
+  }
+  for (i = 0; i < slot_count; i++) {
+    if (gpr_atm_acq_load(&slots[i].state) == SLOT_READY) {
+      used++;
+    }
+  }
+  snprintf(buf, sizeof(buf), "%zu / %zu methods", used, slot_count);
+  php_info_print_table_row(2, "Shared metrics", buf);
+}
@@ -0,0 +1,80 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_METRICS_H_
+#define NET_GRPC_PHP_GRPC_METRICS_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include "php_grpc.h"
+
+#include <grpc/support/atm.h>
+
+#include "stats.h"
+
+/* Longest method name kept by the metrics, longer names are truncated */
+#define GRPC_PHP_METRICS_METHOD_LENGTH 128
+
+/* Class entry for the PHP Metrics class */
+extern zend_class_entry *grpc_ce_metrics;
+
+/* The counters of the calls made to a method by all the processes sharing
+ * the metrics segment */
+typedef struct grpc_php_method_metrics {
+  /* Whether the slot is free, being claimed, or holds a method */
+  gpr_atm state;
+  char method[GRPC_PHP_METRICS_METHOD_LENGTH];
+  grpc_php_call_stats stats;
+} grpc_php_method_metrics;
+
+/* Initializes the Metrics class and, if grpc.metrics is enabled, maps the
+ * metrics segment shared with the processes forked after MINIT */
+void grpc_init_metrics();
+
+/* Unmaps the metrics segment */
+void grpc_shutdown_metrics();
+
+/* Prints the metrics rows of the phpinfo() section */
+void grpc_minfo_metrics();
+
+/* Returns the counters of a method, claiming a slot for it in the shared
+ * segment if needed. Returns NULL if the metrics are disabled */
+grpc_php_call_stats *grpc_php_method_metrics_find(const char *method,
+                                                  size_t method_len);
+
+#endif /* NET_GRPC_PHP_GRPC_METRICS_H_ */
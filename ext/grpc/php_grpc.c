@@ -31,14 +31,22 @@
  *
  */
 
+#include "batch_template.h"
 #include "call.h"
 #include "channel.h"
+#include "channel_pool.h"
 #include "server.h"
 #include "timeval.h"
 #include "channel_credentials.h"
 #include "call_credentials.h"
 #include "server_credentials.h"
 #include "completion_queue.h"
+#include "metadata.h"
+#include "metrics.h"
+#include "bench.h"
+#include "slow_call_log.h"
+#include "stats.h"
+#include "credentials_registry.h"
 
 #ifdef HAVE_CONFIG_H
 #include "config.h"
@@ -49,7 +57,7 @@
 #include <ext/standard/info.h>
 #include "php_grpc.h"
 
-// ZEND_DECLARE_MODULE_GLOBALS(grpc)
+ZEND_DECLARE_MODULE_GLOBALS(grpc)
 
 /* {{{ grpc_functions[]
  *
@@ -68,8 +76,8 @@ zend_module_entry grpc_module_entry = {
     grpc_functions,
     PHP_MINIT(grpc),
     PHP_MSHUTDOWN(grpc),
-    NULL,
-    NULL,
+    PHP_RINIT(grpc),
+    PHP_RSHUTDOWN(grpc),
     PHP_MINFO(grpc),
     PHP_GRPC_VERSION,
     STANDARD_MODULE_PROPERTIES
@@ -85,33 +93,77 @@ ZEND_GET_MODULE(grpc)
 
 /* {{{ PHP_INI
  */
-/* Remove comments and fill if you need to have entries in php.ini
 PHP_INI_BEGIN()
-    STD_PHP_INI_ENTRY("grpc.global_value",      "42", PHP_INI_ALL, OnUpdateLong,
-global_value, zend_grpc_globals, grpc_globals)
-    STD_PHP_INI_ENTRY("grpc.global_string", "foobar", PHP_INI_ALL,
-OnUpdateString, global_string, zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_BOOLEAN("grpc.persistent_channels", "0", PHP_INI_SYSTEM,
+                        OnUpdateBool, persistent_channels,
+                        zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.max_persistent_channels", "64", PHP_INI_SYSTEM,
+                      OnUpdateLong, max_persistent_channels,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.persistent_channel_idle_timeout", "300",
+                      PHP_INI_SYSTEM, OnUpdateLong,
+                      persistent_channel_idle_timeout,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.preconnect_targets", "", PHP_INI_SYSTEM,
+                      OnUpdateString, preconnect_targets,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.preconnect_timeout_ms", "0", PHP_INI_SYSTEM,
+                      OnUpdateLong, preconnect_timeout_ms,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.preconnect_user_agent", "", PHP_INI_SYSTEM,
+                      OnUpdateString, preconnect_user_agent,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.default_keepalive_ms", "0", PHP_INI_ALL,
+                      OnUpdateLong, default_keepalive_ms,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_BOOLEAN("grpc.call_timings", "0", PHP_INI_ALL,
+                        OnUpdateBool, call_timings,
+                        zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.slow_call_threshold_ms", "0", PHP_INI_ALL,
+                      OnUpdateLong, slow_call_threshold_ms,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.slow_call_log", "", PHP_INI_ALL,
+                      OnUpdateString, slow_call_log,
+                      zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_BOOLEAN("grpc.metrics", "0", PHP_INI_SYSTEM,
+                        OnUpdateBool, metrics,
+                        zend_grpc_globals, grpc_globals)
+    STD_PHP_INI_ENTRY("grpc.metrics_max_methods", "256", PHP_INI_SYSTEM,
+                      OnUpdateLong, metrics_max_methods,
+                      zend_grpc_globals, grpc_globals)
 PHP_INI_END()
-*/
 /* }}} */
 
 /* {{{ php_grpc_init_globals
  */
-/* Uncomment this function if you have INI entries
 static void php_grpc_init_globals(zend_grpc_globals *grpc_globals)
 {
-    grpc_globals->global_value = 0;
-    grpc_globals->global_string = NULL;
+    grpc_globals->persistent_channels = 0;
+    grpc_globals->max_persistent_channels = 0;
+    grpc_globals->persistent_channel_idle_timeout = 0;
+    grpc_globals->preconnect_targets = NULL;
+    grpc_globals->preconnect_timeout_ms = 0;
+    grpc_globals->preconnect_user_agent = NULL;
+    grpc_globals->default_keepalive_ms = 0;
+    grpc_globals->call_timings = 0;
+    grpc_globals->slow_call_threshold_ms = 0;
+    grpc_globals->slow_call_log = NULL;
+    memset(&grpc_globals->slow_calls, 0, sizeof(smart_str));
+    grpc_globals->metrics = 0;
+    grpc_globals->metrics_max_methods = 0;
+    grpc_globals->preconnected = 0;
+    memset(grpc_globals->timeval_constants, 0,
+           sizeof(grpc_globals->timeval_constants));
+    ZVAL_UNDEF(&grpc_globals->server_context);
+    grpc_globals->live_calls = NULL;
 }
-*/
 /* }}} */
 
 /* {{{ PHP_MINIT_FUNCTION
  */
 PHP_MINIT_FUNCTION(grpc) {
-  /* If you have INI entries, uncomment these lines
+  ZEND_INIT_MODULE_GLOBALS(grpc, php_grpc_init_globals, NULL);
   REGISTER_INI_ENTRIES();
-  */
   /* Register call error constants */
   grpc_init();
   REGISTER_LONG_CONSTANT("Grpc\\CALL_OK", GRPC_CALL_OK,
@@ -146,6 +198,21 @@ PHP_MINIT_FUNCTION(grpc) {
   REGISTER_LONG_CONSTANT("Grpc\\WRITE_NO_COMPRESS", GRPC_WRITE_NO_COMPRESS,
                          CONST_CS | CONST_PERSISTENT);
 
+  /* Register propagation mask constants */
+  REGISTER_LONG_CONSTANT("Grpc\\PROPAGATE_DEADLINE", GRPC_PROPAGATE_DEADLINE,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\PROPAGATE_CENSUS_STATS_CONTEXT",
+                         GRPC_PROPAGATE_CENSUS_STATS_CONTEXT,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\PROPAGATE_CENSUS_TRACING_CONTEXT",
+                         GRPC_PROPAGATE_CENSUS_TRACING_CONTEXT,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\PROPAGATE_CANCELLATION",
+                         GRPC_PROPAGATE_CANCELLATION,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\PROPAGATE_DEFAULTS", GRPC_PROPAGATE_DEFAULTS,
+                         CONST_CS | CONST_PERSISTENT);
+
   /* Register status constants */
   REGISTER_LONG_CONSTANT("Grpc\\STATUS_OK", GRPC_STATUS_OK,
                          CONST_CS | CONST_PERSISTENT);
@@ -217,6 +284,20 @@ PHP_MINIT_FUNCTION(grpc) {
                          GRPC_OP_RECV_CLOSE_ON_SERVER,
                          CONST_CS | CONST_PERSISTENT);
 
+  /* Register clock type constants */
+  REGISTER_LONG_CONSTANT("Grpc\\CLOCK_MONOTONIC",
+                         GPR_CLOCK_MONOTONIC,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\CLOCK_REALTIME",
+                         GPR_CLOCK_REALTIME,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\CLOCK_PRECISE",
+                         GPR_CLOCK_PRECISE,
+                         CONST_CS | CONST_PERSISTENT);
+  REGISTER_LONG_CONSTANT("Grpc\\CLOCK_TIMESPAN",
+                         GPR_TIMESPAN,
+                         CONST_CS | CONST_PERSISTENT);
+
   /* Register connectivity state constants */
   REGISTER_LONG_CONSTANT("Grpc\\CHANNEL_IDLE",
                          GRPC_CHANNEL_IDLE,
@@ -235,12 +316,20 @@ PHP_MINIT_FUNCTION(grpc) {
                          CONST_CS | CONST_PERSISTENT);
 
   grpc_init_call();
+  grpc_init_batch_template();
+  grpc_init_metadata();
+  grpc_init_metrics();
+#ifdef GRPC_PHP_BENCH
+  grpc_init_bench();
+#endif
   grpc_init_channel();
+  grpc_init_channel_pool();
   grpc_init_server();
   grpc_init_timeval();
   grpc_init_channel_credentials();
   grpc_init_call_credentials();
   grpc_init_server_credentials();
+  grpc_php_init_credentials_registry();
   grpc_php_init_completion_queue();
   return SUCCESS;
 }
@@ -249,28 +338,61 @@ PHP_MINIT_FUNCTION(grpc) {
 /* {{{ PHP_MSHUTDOWN_FUNCTION
  */
 PHP_MSHUTDOWN_FUNCTION(grpc) {
-  /* uncomment this line if you have INI entries
   UNREGISTER_INI_ENTRIES();
-  */
   // WARNING: This function IS being called by PHP when the extension
   // is unloaded but the logs were somehow suppressed.
   grpc_shutdown_timeval();
+  grpc_shutdown_channel();
+  grpc_shutdown_metrics();
+  grpc_shutdown_call_credentials();
+  grpc_php_shutdown_credentials_registry();
   grpc_php_shutdown_completion_queue();
   grpc_shutdown();
   return SUCCESS;
 }
 /* }}} */
 
+/* {{{ PHP_RINIT_FUNCTION
+ */
+PHP_RINIT_FUNCTION(grpc) {
+#if defined(ZTS) && defined(COMPILE_DL_GRPC)
+  ZEND_TSRMLS_CACHE_UPDATE();
+#endif
+  /* MINIT runs in the parent of forking SAPIs such as FPM, where channels
+   * cannot be opened, so each worker connects on its first request */
+  if (!GRPC_G(preconnected)) {
+    GRPC_G(preconnected) = 1;
+    grpc_php_preconnect_channels();
+  }
+  grpc_php_reap_persistent_channels();
+  return SUCCESS;
+}
+/* }}} */
+
+/* {{{ PHP_RSHUTDOWN_FUNCTION
+ */
+PHP_RSHUTDOWN_FUNCTION(grpc) {
+  grpc_rshutdown_call();
+  grpc_rshutdown_slow_call_log();
+  grpc_rshutdown_timeval();
+  return SUCCESS;
+}
+/* }}} */
+
 /* {{{ PHP_MINFO_FUNCTION
  */
 PHP_MINFO_FUNCTION(grpc) {
+  char buf[32];
   php_info_print_table_start();
   php_info_print_table_header(2, "grpc support", "enabled");
+  grpc_minfo_channel();
+  grpc_minfo_stats();
+  grpc_minfo_metrics();
+  snprintf(buf, sizeof(buf), "%d", grpc_php_credentials_registry_count());
+  php_info_print_table_row(2, "Persistent credentials", buf);
   php_info_print_table_end();
 
-  /* Remove comments if you have entries in php.ini
   DISPLAY_INI_ENTRIES();
-  */
 }
 /* }}} */
 /* The previous line is meant for vim and emacs, so it can correctly fold and
@@ -56,9 +56,15 @@ extern zend_module_entry grpc_module_entry;
 #endif
 
 #include "php.h"
+#include "zend_smart_str.h"
 
 #include "grpc/grpc.h"
 
+/* Number of constant values and of clock types of the shared Timeval
+ * objects, see timeval.c */
+#define GRPC_PHP_TIMEVAL_CONSTANTS 3
+#define GRPC_PHP_CLOCK_TYPES 4
+
 #define RETURN_DESTROY_ZVAL(val)                               \
   RETURN_ZVAL(val, false /* Don't execute copy constructor */, \
               true /* Dealloc original before returning */)
@@ -68,18 +74,60 @@ extern zend_module_entry grpc_module_entry;
 PHP_MINIT_FUNCTION(grpc);
 /* Code that runs at module shutdown */
 PHP_MSHUTDOWN_FUNCTION(grpc);
+/* Code that runs at request start */
+PHP_RINIT_FUNCTION(grpc);
+/* Code that runs at request end */
+PHP_RSHUTDOWN_FUNCTION(grpc);
 /* Displays information about the module */
 PHP_MINFO_FUNCTION(grpc);
 
-/*
-    Declare any global variables you may need between the BEGIN
-    and END macros here:
-
 ZEND_BEGIN_MODULE_GLOBALS(grpc)
-  zend_long global_value;
-  char *global_string;
+  /* grpc.persistent_channels: keep channels open across requests */
+  zend_bool persistent_channels;
+  /* grpc.max_persistent_channels: maximum number of persistent channels */
+  zend_long max_persistent_channels;
+  /* grpc.persistent_channel_idle_timeout: seconds after which an unused
+   * persistent channel is closed, 0 to keep them until shutdown */
+  zend_long persistent_channel_idle_timeout;
+  /* grpc.preconnect_targets: targets to connect to when a worker starts */
+  char *preconnect_targets;
+  /* grpc.preconnect_timeout_ms: how long the first request of a worker waits
+   * for the preconnected channels to be ready */
+  zend_long preconnect_timeout_ms;
+  /* grpc.preconnect_user_agent: primary user agent of the preconnected
+   * channels, which only match channels sending the same one */
+  char *preconnect_user_agent;
+  /* grpc.default_keepalive_ms: keepalive time of channels that do not set
+   * one, 0 to leave the grpc default */
+  zend_long default_keepalive_ms;
+  /* grpc.metrics: record call metrics shared by the processes forked after
+   * MINIT */
+  zend_bool metrics;
+  /* grpc.metrics_max_methods: number of methods with metrics of their own */
+  zend_long metrics_max_methods;
+  /* grpc.call_timings: time the phases of the batches of every call */
+  zend_bool call_timings;
+  /* grpc.slow_call_threshold_ms: client calls taking at least this long are
+   * logged, 0 to log none */
+  zend_long slow_call_threshold_ms;
+  /* grpc.slow_call_log: file the slow calls are appended to, the PHP error
+   * log if empty */
+  char *slow_call_log;
+  /* The slow call lines of the request that have not been written yet */
+  smart_str slow_calls;
+  /* Whether the preconnect targets have been connected in this worker */
+  zend_bool preconnected;
+  /* Timeval objects returned by zero(), infFuture() and infPast() during the
+   * request, by value and clock type */
+  zend_object *timeval_constants[GRPC_PHP_TIMEVAL_CONSTANTS]
+                                [GRPC_PHP_CLOCK_TYPES];
+  /* The server call that client calls of the request propagate from */
+  zval server_context;
+  /* The calls of the request, linked through their live links */
+  struct wrapped_grpc_call *live_calls;
 ZEND_END_MODULE_GLOBALS(grpc)
-*/
+
+ZEND_EXTERN_MODULE_GLOBALS(grpc)
 
 /* Always refer to the globals in your function as GRPC_G(variable).
    You are encouraged to rename these macros something shorter, see
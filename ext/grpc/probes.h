@@ -0,0 +1,73 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_PROBES_H_
+#define NET_GRPC_PHP_GRPC_PROBES_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/* Static tracepoints of the "grpc" provider, for SystemTap, bpftrace or perf.
+ * Each one compiles to a nop and a note in the binary, so they cost nothing
+ * until a tracer attaches to them. Their arguments:
+ *
+ *   call__create(method, call)
+ *   batch__start(method, call, op_num)
+ *   batch__done(method, call, op_num)
+ *   call__finish(method, call, status, bytes_sent, bytes_received)
+ *   unary__start(method, request_bytes)
+ *   server__request__call(method, host, call)
+ *   metadata__parse(count)
+ *   metadata__create(count)
+ *   byte__buffer__read(bytes)
+ *   byte__buffer__write(bytes)
+ *
+ * where method and host are strings, and method is NULL for server calls */
+#ifdef HAVE_SYS_SDT_H
+#include <sys/sdt.h>
+
+#define GRPC_PHP_PROBE1(name, a1) DTRACE_PROBE1(grpc, name, a1)
+#define GRPC_PHP_PROBE2(name, a1, a2) DTRACE_PROBE2(grpc, name, a1, a2)
+#define GRPC_PHP_PROBE3(name, a1, a2, a3) \
+  DTRACE_PROBE3(grpc, name, a1, a2, a3)
+#define GRPC_PHP_PROBE5(name, a1, a2, a3, a4, a5) \
+  DTRACE_PROBE5(grpc, name, a1, a2, a3, a4, a5)
+#else
+#define GRPC_PHP_PROBE1(name, a1)
+#define GRPC_PHP_PROBE2(name, a1, a2)
+#define GRPC_PHP_PROBE3(name, a1, a2, a3)
+#define GRPC_PHP_PROBE5(name, a1, a2, a3, a4, a5)
+#endif
+
+#endif /* NET_GRPC_PHP_GRPC_PROBES_H_ */
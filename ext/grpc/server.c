@@ -51,6 +51,7 @@
 #include <grpc/grpc_security.h>
 
 #include "completion_queue.h"
+#include "probes.h"
 #include "server.h"
 #include "channel.h"
 #include "server_credentials.h"
@@ -165,6 +166,7 @@ PHP_METHOD(Server, requestCall) {
                          "Failed to request a call for some reason", 1);
     goto cleanup;
   }
+  GRPC_PHP_PROBE3(server__request__call, details.method, details.host, call);
   //TODO(thinkerou): use zval or zval*?
   zval zv_call;
   zval zv_timeval;
@@ -42,6 +42,7 @@
 #include <ext/standard/info.h>
 #include <ext/spl/spl_exceptions.h>
 #include "php_grpc.h"
+#include "credentials_registry.h"
 
 #include <zend_exceptions.h>
 #include <zend_hash.h>
@@ -57,7 +58,7 @@ static zend_object_handlers server_creds_object_handlers_server_creds;
 static void free_wrapped_grpc_server_credentials(zend_object *object) {
   wrapped_grpc_server_credentials *creds =
     wrapped_grpc_server_creds_from_obj(object);
-  if (creds->wrapped != NULL) {
+  if (creds->owned && creds->wrapped != NULL) {
     grpc_server_credentials_release(creds->wrapped);
   }
   zend_object_std_dtor(&creds->std);
@@ -79,12 +80,17 @@ zend_object *create_wrapped_grpc_server_credentials(
   return &intern->std;
 }
 
+/* Wraps a grpc_server_credentials struct in a PHP object. Owned indicates
+   whether the struct should be released at the end of the object's
+   lifecycle */
 void grpc_php_wrap_server_credentials(grpc_server_credentials *wrapped,
+                                      bool owned,
                                       zval *server_credentials_object) {
   object_init_ex(server_credentials_object, grpc_ce_server_credentials);
   wrapped_grpc_server_credentials *server_credentials =
     Z_WRAPPED_GRPC_SERVER_CREDS_P(server_credentials_object);
   server_credentials->wrapped = wrapped;
+  server_credentials->owned = owned;
 }
 
 /**
@@ -124,13 +130,25 @@ PHP_METHOD(ServerCredentials, createSsl) {
   if (cert_chain) {
       pem_key_cert_pair.cert_chain = ZSTR_VAL(cert_chain);
   }
+  char key[GRPC_PHP_CREDENTIALS_KEY_LENGTH];
+  zend_string *key_parts[] = {pem_root_certs, private_key, cert_chain};
+  grpc_php_credentials_registry_key(GRPC_PHP_SERVER_CREDENTIALS, key_parts,
+                                    3, key);
+  grpc_server_credentials *creds = grpc_php_credentials_registry_find(key);
+  if (creds != NULL) {
+    grpc_php_wrap_server_credentials(creds, false, return_value);
+    RETURN_DESTROY_ZVAL(return_value);
+  }
+
   /* TODO: add a client_certificate_request field in ServerCredentials and pass
    * it as the last parameter. */
-  grpc_server_credentials *creds = grpc_ssl_server_credentials_create_ex(
+  creds = grpc_ssl_server_credentials_create_ex(
       pem_root_certs == NULL ? NULL : ZSTR_VAL(pem_root_certs),
       &pem_key_cert_pair, 1,
       GRPC_SSL_DONT_REQUEST_CLIENT_CERTIFICATE, NULL);
-  grpc_php_wrap_server_credentials(creds, return_value);
+  bool registered = grpc_php_credentials_registry_add(
+      key, GRPC_PHP_SERVER_CREDENTIALS, creds);
+  grpc_php_wrap_server_credentials(creds, !registered, return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
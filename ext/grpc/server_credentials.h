@@ -52,6 +52,7 @@ extern zend_class_entry *grpc_ce_server_credentials;
 /* Wrapper struct for grpc_server_credentials that can be associated with a PHP
  * object */
 typedef struct wrapped_grpc_server_credentials {
+  bool owned;
   grpc_server_credentials *wrapped;
   zend_object std;
 } wrapped_grpc_server_credentials;
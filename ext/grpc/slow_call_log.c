@@ -0,0 +1,182 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "slow_call_log.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include "php_grpc.h"
+
+#include <zend_smart_str.h>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <grpc/support/alloc.h>
+
+/* The buffered lines are written before adding one would take the buffer
+ * over this size, so that a long running script does not hold them all */
+#define FLUSH_SIZE (64 * 1024)
+
+/* Appends a string as a JSON string */
+static void append_json_string(smart_str *out, const char *value,
+                               size_t len) {
+  static const char hex[] = "0123456789abcdef";
+  size_t i;
+  unsigned char c;
+  smart_str_appendc(out, '"');
+  for (i = 0; i < len; i++) {
+    c = (unsigned char)value[i];
+    if (c == '"' || c == '\\') {
+      smart_str_appendc(out, '\\');
+      smart_str_appendc(out, c);
+    } else if (c < 0x20) {
+      smart_str_appendl(out, "\\u00", 4);
+      smart_str_appendc(out, hex[c >> 4]);
+      smart_str_appendc(out, hex[c & 0xf]);
+    } else {
+      smart_str_appendc(out, c);
+    }
+  }
+  smart_str_appendc(out, '"');
+}
+
+/* Appends a "key":value member holding an integer */
+static void append_json_long(smart_str *out, const char *key, int64_t value) {
+  smart_str_appendc(out, ',');
+  append_json_string(out, key, strlen(key));
+  smart_str_appendc(out, ':');
+  smart_str_append_long(out, (zend_long)value);
+}
+
+/* Returns the milliseconds from start to end */
+static int64_t elapsed_ms(gpr_timespec start, gpr_timespec end) {
+  gpr_timespec diff = gpr_time_sub(end, start);
+  return (int64_t)diff.tv_sec * GPR_MS_PER_SEC +
+      diff.tv_nsec / GPR_NS_PER_MS;
+}
+
+/* The lines are written to grpc.slow_call_log, or to the PHP error log if it
+ * is not set. This happens when the buffer is full or the request ends, not
+ * while calls are made. The file is appended to with a single write, so the
+ * lines of concurrent workers do not interleave */
+void grpc_php_flush_slow_call_log() {
+  smart_str *lines = &GRPC_G(slow_calls);
+  const char *path = GRPC_G(slow_call_log);
+  int fd;
+  if (lines->s == NULL) {
+    return;
+  }
+  smart_str_0(lines);
+  if (path == NULL || path[0] == '\0') {
+    /* The error log takes one message at a time, without its newline */
+    char *line = ZSTR_VAL(lines->s);
+    char *end;
+    while ((end = strchr(line, '\n')) != NULL) {
+      *end = '\0';
+      php_log_err(line);
+      line = end + 1;
+    }
+  } else {
+    fd = open(path, O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd >= 0) {
+      if (write(fd, ZSTR_VAL(lines->s), ZSTR_LEN(lines->s)) < 0) {
+        /* The lines are dropped rather than delaying the request */
+      }
+      close(fd);
+    }
+  }
+  smart_str_free(lines);
+}
+
+void grpc_php_log_slow_call(const grpc_php_slow_call *call) {
+  gpr_timespec now = gpr_now(GPR_CLOCK_MONOTONIC);
+  int64_t duration_ms = elapsed_ms(call->start_time, now);
+  smart_str line = {0};
+  gpr_timespec deadline;
+  char *peer;
+
+  if (duration_ms < GRPC_G(slow_call_threshold_ms)) {
+    return;
+  }
+
+  smart_str_appends(&line, "{\"time\":");
+  smart_str_append_long(&line, (zend_long)time(NULL));
+  smart_str_appends(&line, ",\"method\":");
+  append_json_string(&line, call->method, call->method_len);
+  smart_str_appends(&line, ",\"target\":");
+  if (call->target == NULL) {
+    smart_str_appends(&line, "null");
+  } else {
+    append_json_string(&line, call->target, strlen(call->target));
+  }
+  peer = grpc_call_get_peer(call->call);
+  smart_str_appends(&line, ",\"peer\":");
+  append_json_string(&line, peer, strlen(peer));
+  gpr_free(peer);
+  append_json_long(&line, "status", call->status);
+  append_json_long(&line, "duration_ms", duration_ms);
+  append_json_long(&line, "bytes_sent", call->bytes_sent);
+  append_json_long(&line, "bytes_received", call->bytes_received);
+  deadline = gpr_convert_clock_type(call->deadline, GPR_CLOCK_MONOTONIC);
+  if (gpr_time_cmp(deadline, gpr_inf_future(GPR_CLOCK_MONOTONIC)) == 0) {
+    smart_str_appends(&line, ",\"deadline_remaining_ms\":null");
+  } else {
+    append_json_long(&line, "deadline_remaining_ms",
+                     elapsed_ms(now, deadline));
+  }
+  if (call->timings != NULL) {
+    append_json_long(&line, "batches", call->timings->batches);
+    append_json_long(&line, "build_ns", call->timings->build_ns);
+    append_json_long(&line, "wait_ns", call->timings->wait_ns);
+    append_json_long(&line, "convert_ns", call->timings->convert_ns);
+  }
+  smart_str_appends(&line, "}\n");
+
+  if (GRPC_G(slow_calls).s != NULL &&
+      ZSTR_LEN(GRPC_G(slow_calls).s) + ZSTR_LEN(line.s) > FLUSH_SIZE) {
+    grpc_php_flush_slow_call_log();
+  }
+  smart_str_append(&GRPC_G(slow_calls), line.s);
+  smart_str_free(&line);
+}
+
+void grpc_rshutdown_slow_call_log() {
+  grpc_php_flush_slow_call_log();
+}
@@ -0,0 +1,82 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_SLOW_CALL_LOG_H_
+#define NET_GRPC_PHP_GRPC_SLOW_CALL_LOG_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include "php_grpc.h"
+
+#include <grpc/grpc.h>
+#include <grpc/support/time.h>
+
+#include "call.h"
+
+/* A completed client call, as described in the slow call log */
+typedef struct grpc_php_slow_call {
+  const char *method;
+  size_t method_len;
+  /* The target of the channel of the call, or NULL if it is not known */
+  const char *target;
+  grpc_call *call;
+  grpc_status_code status;
+  size_t bytes_sent;
+  size_t bytes_received;
+  gpr_timespec start_time;
+  gpr_timespec deadline;
+  /* The phases of the batches of the call, or NULL if it was not timed */
+  const grpc_php_call_timings *timings;
+} grpc_php_slow_call;
+
+/* Whether completed client calls have to be checked against
+ * grpc.slow_call_threshold_ms */
+static inline bool grpc_php_slow_call_log_enabled() {
+  return GRPC_G(slow_call_threshold_ms) > 0;
+}
+
+/* Adds a line describing a call to the slow call log if it took longer than
+ * grpc.slow_call_threshold_ms. Lines are buffered and only written when the
+ * buffer is full or the request ends */
+void grpc_php_log_slow_call(const grpc_php_slow_call *call);
+
+/* Writes the buffered slow call lines to grpc.slow_call_log */
+void grpc_php_flush_slow_call_log();
+
+/* Writes the slow calls of the request to grpc.slow_call_log */
+void grpc_rshutdown_slow_call_log();
+
+#endif /* NET_GRPC_PHP_GRPC_SLOW_CALL_LOG_H_ */
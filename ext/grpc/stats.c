@@ -0,0 +1,271 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "stats.h"
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include <php_ini.h>
+#include <ext/standard/info.h>
+#include "php_grpc.h"
+
+grpc_php_call_stats grpc_php_process_stats;
+
+#define SUB_BUCKETS (1 << GRPC_PHP_LATENCY_SUB_BITS)
+
+/* Returns the index of the most significant bit set in v, which is not 0 */
+static inline int most_significant_bit(uint64_t v) {
+#ifdef __GNUC__
+  return 63 - __builtin_clzll(v);
+#else
+  int bit = 0;
+  while (v >>= 1) {
+    bit++;
+  }
+  return bit;
+#endif
+}
+
+/* Returns the histogram bucket of a latency in microseconds. Latencies below
+ * SUB_BUCKETS have a bucket each, and every power of two above is split in
+ * SUB_BUCKETS buckets of equal width */
+static int latency_bucket(uint64_t us) {
+  int bit;
+  if (us < SUB_BUCKETS) {
+    return (int)us;
+  }
+  if (us >= (UINT64_C(1) << GRPC_PHP_LATENCY_MAX_BITS)) {
+    us = (UINT64_C(1) << GRPC_PHP_LATENCY_MAX_BITS) - 1;
+  }
+  bit = most_significant_bit(us);
+  return ((bit - GRPC_PHP_LATENCY_SUB_BITS + 1) << GRPC_PHP_LATENCY_SUB_BITS) +
+      (int)((us >> (bit - GRPC_PHP_LATENCY_SUB_BITS)) & (SUB_BUCKETS - 1));
+}
+
+/* Returns the smallest latency that falls in a bucket */
+static uint64_t bucket_lower_bound(int bucket) {
+  int bit;
+  if (bucket < SUB_BUCKETS) {
+    return (uint64_t)bucket;
+  }
+  bit = (bucket >> GRPC_PHP_LATENCY_SUB_BITS) + GRPC_PHP_LATENCY_SUB_BITS - 1;
+  return (uint64_t)(SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1)))
+      << (bit - GRPC_PHP_LATENCY_SUB_BITS);
+}
+
+uint64_t grpc_php_latency_bucket_upper_bound(int bucket) {
+  if (bucket + 1 >= GRPC_PHP_LATENCY_BUCKETS) {
+    return UINT64_MAX;
+  }
+  return bucket_lower_bound(bucket + 1) - 1;
+}
+
+/* Raises max to value if it is lower */
+static void atm_max(gpr_atm *max, gpr_atm value) {
+  gpr_atm current = gpr_atm_no_barrier_load(max);
+  while (value > current) {
+    if (gpr_atm_no_barrier_cas(max, current, value)) {
+      return;
+    }
+    current = gpr_atm_no_barrier_load(max);
+  }
+}
+
+/* Adds a completed call to a single set of counters */
+static void add_finished(grpc_php_call_stats *stats, grpc_status_code status,
+                         int64_t us, int bucket) {
+  gpr_atm_no_barrier_fetch_add(&stats->calls_by_status[status], 1);
+  gpr_atm_no_barrier_fetch_add(&stats->latency_sum_us, (gpr_atm)us);
+  gpr_atm_no_barrier_fetch_add(&stats->latency_buckets[bucket], 1);
+  atm_max(&stats->latency_max_us, (gpr_atm)us);
+}
+
+/* Adds message bytes to a single set of counters */
+static void add_bytes(grpc_php_call_stats *stats, size_t sent,
+                      size_t received) {
+  if (sent > 0) {
+    gpr_atm_no_barrier_fetch_add(&stats->bytes_sent, (gpr_atm)sent);
+  }
+  if (received > 0) {
+    gpr_atm_no_barrier_fetch_add(&stats->bytes_received, (gpr_atm)received);
+  }
+}
+
+void grpc_php_stats_call_started(grpc_php_call_stats *stats,
+                                 grpc_php_call_stats *method_stats) {
+  gpr_atm_no_barrier_fetch_add(&stats->calls_started, 1);
+  gpr_atm_no_barrier_fetch_add(&grpc_php_process_stats.calls_started, 1);
+  if (method_stats != NULL) {
+    gpr_atm_no_barrier_fetch_add(&method_stats->calls_started, 1);
+  }
+}
+
+void grpc_php_stats_call_finished(grpc_php_call_stats *stats,
+                                  grpc_php_call_stats *method_stats,
+                                  grpc_status_code status,
+                                  gpr_timespec start) {
+  gpr_timespec elapsed = gpr_time_sub(gpr_now(GPR_CLOCK_MONOTONIC), start);
+  int64_t us = elapsed.tv_sec * GPR_US_PER_SEC +
+      elapsed.tv_nsec / GPR_NS_PER_US;
+  int bucket;
+  if (us < 0) {
+    us = 0;
+  }
+  if (status < 0 || status >= GRPC_PHP_STATUS_CODES) {
+    status = GRPC_STATUS_UNKNOWN;
+  }
+  bucket = latency_bucket((uint64_t)us);
+  add_finished(stats, status, us, bucket);
+  add_finished(&grpc_php_process_stats, status, us, bucket);
+  if (method_stats != NULL) {
+    add_finished(method_stats, status, us, bucket);
+  }
+}
+
+void grpc_php_stats_add_bytes(grpc_php_call_stats *stats,
+                              grpc_php_call_stats *method_stats,
+                              size_t sent, size_t received) {
+  add_bytes(stats, sent, received);
+  add_bytes(&grpc_php_process_stats, sent, received);
+  if (method_stats != NULL) {
+    add_bytes(method_stats, sent, received);
+  }
+}
+
+/* Returns the number of completed calls, and how many of them failed */
+static gpr_atm calls_finished(grpc_php_call_stats *stats, gpr_atm *failed) {
+  gpr_atm finished = 0;
+  int status;
+  for (status = 0; status < GRPC_PHP_STATUS_CODES; status++) {
+    finished += gpr_atm_no_barrier_load(&stats->calls_by_status[status]);
+  }
+  *failed = finished -
+      gpr_atm_no_barrier_load(&stats->calls_by_status[GRPC_STATUS_OK]);
+  return finished;
+}
+
+/* Returns the upper bound of the latency below which a fraction quantile of
+ * the count recorded latencies fall, capped at the largest latency */
+static uint64_t latency_quantile(grpc_php_call_stats *stats, gpr_atm count,
+                                 double quantile) {
+  uint64_t max = (uint64_t)gpr_atm_no_barrier_load(&stats->latency_max_us);
+  double rank = quantile * (double)count;
+  gpr_atm seen = 0;
+  uint64_t bound;
+  int bucket;
+  for (bucket = 0; bucket < GRPC_PHP_LATENCY_BUCKETS; bucket++) {
+    seen += gpr_atm_no_barrier_load(&stats->latency_buckets[bucket]);
+    if ((double)seen >= rank && seen > 0) {
+      bound = bucket + 1 < GRPC_PHP_LATENCY_BUCKETS ?
+          bucket_lower_bound(bucket + 1) - 1 : max;
+      return bound < max ? bound : max;
+    }
+  }
+  return max;
+}
+
+void grpc_php_stats_to_array(grpc_php_call_stats *stats,
+                             zend_long calls_in_flight, zval *array) {
+  gpr_atm failed;
+  gpr_atm finished = calls_finished(stats, &failed);
+  gpr_atm count;
+  gpr_atm calls;
+  zval status_codes;
+  zval latency;
+  int status;
+
+  array_init(array);
+  add_assoc_long(array, "calls_started",
+                 gpr_atm_no_barrier_load(&stats->calls_started));
+  add_assoc_long(array, "calls_succeeded", finished - failed);
+  add_assoc_long(array, "calls_failed", failed);
+  add_assoc_long(array, "calls_in_flight", calls_in_flight);
+
+  array_init(&status_codes);
+  for (status = 0; status < GRPC_PHP_STATUS_CODES; status++) {
+    calls = gpr_atm_no_barrier_load(&stats->calls_by_status[status]);
+    if (calls > 0) {
+      add_index_long(&status_codes, status, calls);
+    }
+  }
+  add_assoc_zval(array, "status_codes", &status_codes);
+
+  add_assoc_long(array, "bytes_sent",
+                 gpr_atm_no_barrier_load(&stats->bytes_sent));
+  add_assoc_long(array, "bytes_received",
+                 gpr_atm_no_barrier_load(&stats->bytes_received));
+
+  count = finished;
+  array_init(&latency);
+  add_assoc_long(&latency, "count", count);
+  add_assoc_long(&latency, "mean", count == 0 ? 0 :
+                 gpr_atm_no_barrier_load(&stats->latency_sum_us) / count);
+  add_assoc_long(&latency, "p50",
+                 (zend_long)latency_quantile(stats, count, 0.5));
+  add_assoc_long(&latency, "p90",
+                 (zend_long)latency_quantile(stats, count, 0.9));
+  add_assoc_long(&latency, "p99",
+                 (zend_long)latency_quantile(stats, count, 0.99));
+  add_assoc_long(&latency, "max",
+                 gpr_atm_no_barrier_load(&stats->latency_max_us));
+  add_assoc_zval(array, "latency_us", &latency);
+}
+
+void grpc_minfo_stats() {
+  char buf[64];
+  gpr_atm failed;
+  gpr_atm finished = calls_finished(&grpc_php_process_stats, &failed);
+  snprintf(buf, sizeof(buf), "%ld",
+           (long)gpr_atm_no_barrier_load(
+               &grpc_php_process_stats.calls_started));
+  php_info_print_table_row(2, "Calls started", buf);
+  snprintf(buf, sizeof(buf), "%ld / %ld", (long)(finished - failed),
+           (long)failed);
+  php_info_print_table_row(2, "Calls succeeded / failed", buf);
+  snprintf(buf, sizeof(buf), "%ld / %ld",
+           (long)gpr_atm_no_barrier_load(&grpc_php_process_stats.bytes_sent),
+           (long)gpr_atm_no_barrier_load(
+               &grpc_php_process_stats.bytes_received));
+  php_info_print_table_row(2, "Bytes sent / received", buf);
+  snprintf(buf, sizeof(buf), "%lu / %lu / %lu",
+           (unsigned long)latency_quantile(&grpc_php_process_stats, finished,
+                                           0.5),
+           (unsigned long)latency_quantile(&grpc_php_process_stats, finished,
+                                           0.99),
+           (unsigned long)gpr_atm_no_barrier_load(
+               &grpc_php_process_stats.latency_max_us));
+  php_info_print_table_row(2, "Call latency p50 / p99 / max (us)", buf);
+}
@@ -0,0 +1,107 @@
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef NET_GRPC_PHP_GRPC_STATS_H_
+#define NET_GRPC_PHP_GRPC_STATS_H_
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <php.h>
+#include "php_grpc.h"
+
+#include <grpc/grpc.h>
+#include <grpc/support/atm.h>
+#include <grpc/support/time.h>
+
+/* Number of grpc_status_code values */
+#define GRPC_PHP_STATUS_CODES (GRPC_STATUS_UNAUTHENTICATED + 1)
+
+/* The latency histogram splits each power of two into 2^SUB_BITS buckets,
+ * which keeps the relative error of a recorded latency under 12.5% */
+#define GRPC_PHP_LATENCY_SUB_BITS 3
+
+/* Latencies are recorded in microseconds, up to 2^MAX_BITS (about 19 hours) */
+#define GRPC_PHP_LATENCY_MAX_BITS 36
+
+#define GRPC_PHP_LATENCY_BUCKETS                                   \
+  ((GRPC_PHP_LATENCY_MAX_BITS - GRPC_PHP_LATENCY_SUB_BITS + 1)     \
+   << GRPC_PHP_LATENCY_SUB_BITS)
+
+/* Counters of the calls made on a channel. They are only ever updated
+ * atomically, so recording a call takes no lock and no allocation */
+typedef struct grpc_php_call_stats {
+  gpr_atm calls_started;
+  /* Completed calls, by the status code they ended with */
+  gpr_atm calls_by_status[GRPC_PHP_STATUS_CODES];
+  gpr_atm bytes_sent;
+  gpr_atm bytes_received;
+  gpr_atm latency_sum_us;
+  gpr_atm latency_max_us;
+  gpr_atm latency_buckets[GRPC_PHP_LATENCY_BUCKETS];
+} grpc_php_call_stats;
+
+/* Counters of all the calls made by the process */
+extern grpc_php_call_stats grpc_php_process_stats;
+
+/* Counts a call started on a channel, in the counters of the channel, of
+ * the process and, unless it is NULL, of the method */
+void grpc_php_stats_call_started(grpc_php_call_stats *stats,
+                                 grpc_php_call_stats *method_stats);
+
+/* Counts a call that ended with status, started at start on the monotonic
+ * clock */
+void grpc_php_stats_call_finished(grpc_php_call_stats *stats,
+                                  grpc_php_call_stats *method_stats,
+                                  grpc_status_code status,
+                                  gpr_timespec start);
+
+/* Counts the bytes of messages sent and received by a call */
+void grpc_php_stats_add_bytes(grpc_php_call_stats *stats,
+                              grpc_php_call_stats *method_stats,
+                              size_t sent, size_t received);
+
+/* Returns the largest latency in microseconds that falls in a bucket of the
+ * latency histogram */
+uint64_t grpc_php_latency_bucket_upper_bound(int bucket);
+
+/* Fills array with the counters of stats and calls_in_flight, in the format
+ * returned by Channel::getStats */
+void grpc_php_stats_to_array(grpc_php_call_stats *stats,
+                             zend_long calls_in_flight, zval *array);
+
+/* Prints the call statistics rows of the phpinfo() section */
+void grpc_minfo_stats();
+
+#endif /* NET_GRPC_PHP_GRPC_STATS_H_ */
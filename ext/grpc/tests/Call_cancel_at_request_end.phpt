@@ -0,0 +1,71 @@
+--TEST--
+Test the open calls of a request are cancelled when it ends or times out
+--SKIPIF--
+<?php
+if (!extension_loaded("grpc")) print "skip";
+// Before PHP 7.1 the time limit is not seen while waiting for a batch
+if (PHP_VERSION_ID < 70100) print "skip needs PHP 7.1";
+if (DIRECTORY_SEPARATOR !== '/') print "skip needs a POSIX shell";
+?>
+--INI--
+max_execution_time=30
+--FILE--
+<?php
+$server = new Grpc\Server([]);
+$port = $server->addHttp2Port('127.0.0.1:0');
+$server->start();
+
+// Another process starts a streaming call and ends its script with the call
+// still open
+$client = tempnam(sys_get_temp_dir(), 'grpc');
+file_put_contents($client, '<?php
+$channel = new Grpc\Channel("127.0.0.1:".$argv[1], [
+    "credentials" => Grpc\ChannelCredentials::createInsecure(),
+]);
+$call = new Grpc\Call($channel, "/abc/stream", Grpc\Timeval::infFuture());
+$call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => []]);
+// A second reference keeps the call alive until the request ends
+$calls = [$call];
+fgets(STDIN);
+');
+$process = proc_open(
+    escapeshellarg(PHP_BINARY).
+    ' -d extension_dir='.escapeshellarg(ini_get('extension_dir')).
+    ' -d extension=grpc.'.PHP_SHLIB_SUFFIX.
+    ' '.escapeshellarg($client).' '.$port,
+    [['pipe', 'r'], ['file', '/dev/null', 'w'], ['file', '/dev/null', 'w']],
+    $pipes);
+$event = $server->requestCall();
+var_dump($event->method);
+fwrite($pipes[0], "end\n");
+$event = $event->call->startBatch([
+    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+]);
+var_dump($event->cancelled);
+fclose($pipes[0]);
+proc_close($process);
+unlink($client);
+
+// A batch waiting for a server that never answers returns once the time
+// limit is reached, which another process signals after a second
+$channel = new Grpc\Channel('127.0.0.1:'.$port, [
+    'credentials' => Grpc\ChannelCredentials::createInsecure(),
+]);
+$call = new Grpc\Call($channel, '/abc/wait', Grpc\Timeval::infFuture());
+$start = microtime(true);
+register_shutdown_function(function () use ($start) {
+    var_dump(microtime(true) - $start < 10);
+});
+$timer = proc_open('sleep 1; kill -PROF '.getmypid(), [], $pipes);
+$call->startBatch([
+    Grpc\OP_SEND_INITIAL_METADATA => [],
+    Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+]);
+echo "not reached\n";
+?>
+--EXPECTF--
+string(11) "/abc/stream"
+bool(true)
+
+Fatal error: Maximum execution time of %d second%s exceeded in %s on line %d
+bool(true)
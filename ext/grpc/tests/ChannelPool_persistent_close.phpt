@@ -0,0 +1,44 @@
+--TEST--
+Test closing a pool gives its persistent channels back to the registry
+--SKIPIF--
+<?php if (!extension_loaded("grpc")) print "skip"; ?>
+--INI--
+grpc.persistent_channels=1
+grpc.max_persistent_channels=2
+--FILE--
+<?php
+$opts = ['credentials' => Grpc\ChannelCredentials::createInsecure()];
+$pool1 = new Grpc\ChannelPool('localhost:1', $opts, 2);
+foreach ($pool1->getChannels() as $channel) {
+    var_dump($channel->isPersistent());
+}
+$pool1->close();
+foreach ($pool1->getChannels() as $channel) {
+    var_dump($channel->isPersistent());
+}
+// The reopened pool shares the channels that are still open in the
+// registry
+$pool2 = new Grpc\ChannelPool('localhost:1', $opts, 2);
+foreach ($pool2->getChannels() as $channel) {
+    var_dump($channel->isPersistent());
+    var_dump($channel->getConnectivityState() >= 0);
+}
+$pool2->close();
+$pool3 = new Grpc\ChannelPool('localhost:1', $opts, 2);
+var_dump($pool3->getChannel()->isPersistent());
+var_dump($pool3->getConnectivityState() >= 0);
+$pool3->close();
+?>
+===DONE===
+--EXPECT--
+bool(true)
+bool(true)
+bool(false)
+bool(false)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+bool(true)
+===DONE===
@@ -0,0 +1,47 @@
+--TEST--
+Test persistent channels are shared between Channel objects
+--SKIPIF--
+<?php if (!extension_loaded("grpc")) print "skip"; ?>
+--INI--
+grpc.persistent_channels=1
+grpc.max_persistent_channels=2
+--FILE--
+<?php
+$opts = ['credentials' => Grpc\ChannelCredentials::createInsecure()];
+$channel1 = new Grpc\Channel('localhost:1', $opts);
+var_dump($channel1->isPersistent());
+$channel1->close();
+$channel2 = new Grpc\Channel('localhost:1', $opts);
+var_dump($channel2->isPersistent());
+var_dump($channel2->getTarget());
+$channel3 = new Grpc\Channel('localhost:2', $opts);
+var_dump($channel3->isPersistent());
+// The registry is full
+$channel4 = new Grpc\Channel('localhost:3', $opts);
+var_dump($channel4->isPersistent());
+// Credentials owned by the request cannot be shared
+$channel5 = new Grpc\Channel('localhost:1', [
+    'credentials' => Grpc\ChannelCredentials::createComposite(
+        Grpc\ChannelCredentials::createSsl(),
+        Grpc\CallCredentials::createFromPlugin(function ($context) {
+            return [];
+        })),
+]);
+var_dump($channel5->isPersistent());
+// The registry is full, so a channel sending another user agent cannot
+// share the one of localhost:1
+$channel6 = new Grpc\Channel('localhost:1', $opts + [
+    'grpc.primary_user_agent' => 'other',
+]);
+var_dump($channel6->isPersistent());
+?>
+===DONE===
+--EXPECT--
+bool(true)
+bool(true)
+string(11) "localhost:1"
+bool(true)
+bool(false)
+bool(false)
+bool(false)
+===DONE===
@@ -0,0 +1,31 @@
+--TEST--
+Test the shared call metrics are exported per method
+--SKIPIF--
+<?php if (!extension_loaded("grpc")) print "skip"; ?>
+--INI--
+grpc.metrics=1
+grpc.metrics_max_methods=1
+--FILE--
+<?php
+$channel = new Grpc\Channel('localhost:1', [
+    'credentials' => Grpc\ChannelCredentials::createInsecure(),
+]);
+$deadline = Grpc\Timeval::infFuture();
+new Grpc\Call($channel, '/foo/bar', $deadline);
+new Grpc\Call($channel, '/foo/bar', $deadline);
+// The only method slot is taken
+new Grpc\Call($channel, '/foo/baz', $deadline);
+$metrics = Grpc\Metrics::export();
+var_dump(strpos($metrics,
+    "grpc_client_started_total{method=\"/foo/bar\"} 2\n") !== false);
+var_dump(strpos($metrics,
+    "grpc_client_started_total{method=\"__other__\"} 1\n") !== false);
+var_dump(strpos($metrics,
+    "# TYPE grpc_client_call_duration_seconds histogram\n") !== false);
+?>
+===DONE===
+--EXPECT--
+bool(true)
+bool(true)
+bool(true)
+===DONE===
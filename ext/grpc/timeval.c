@@ -81,6 +81,127 @@ void grpc_php_wrap_timeval(gpr_timespec wrapped, zval *timeval_object) {
   memcpy(&timeval->wrapped, &wrapped, sizeof(gpr_timespec));
 }
 
+/* The objects returned by zero(), infFuture() and infPast() are shared by
+ * every caller in the request, so Grpc\Timeval objects take no properties.
+ * Instances of subclasses are never shared and keep the standard behavior */
+#if PHP_VERSION_ID >= 70400
+static zval *timeval_write_property(zval *object, zval *member, zval *value,
+                                    void **cache_slot) {
+  if (Z_OBJCE_P(object) != grpc_ce_timeval) {
+    return zend_std_write_property(object, member, value, cache_slot);
+  }
+  zend_throw_exception(spl_ce_LogicException,
+                       "Timeval objects cannot have properties", 1);
+  return &EG(error_zval);
+}
+#else
+static void timeval_write_property(zval *object, zval *member, zval *value,
+                                   void **cache_slot) {
+  if (Z_OBJCE_P(object) != grpc_ce_timeval) {
+    zend_std_write_property(object, member, value, cache_slot);
+    return;
+  }
+  zend_throw_exception(spl_ce_LogicException,
+                       "Timeval objects cannot have properties", 1);
+}
+#endif
+
+/* Without a pointer to the property, the engine falls back to
+ * timeval_write_property for indirect writes such as $timeval->a[] = 1 */
+static zval *timeval_get_property_ptr_ptr(zval *object, zval *member,
+                                          int type, void **cache_slot) {
+  if (Z_OBJCE_P(object) != grpc_ce_timeval) {
+    return zend_std_get_property_ptr_ptr(object, member, type, cache_slot);
+  }
+  return NULL;
+}
+
+/* Values of the shared constant Timeval objects */
+enum {
+  TIMEVAL_ZERO,
+  TIMEVAL_INF_FUTURE,
+  TIMEVAL_INF_PAST
+};
+
+/* Checks that clock is one of the Grpc\CLOCK_* constants, throwing otherwise.
+ * GPR_TIMESPAN is only accepted if allow_timespan is set */
+static bool read_clock_type(zend_long clock, bool allow_timespan,
+                            gpr_clock_type *clock_type) {
+  if (clock != GPR_CLOCK_MONOTONIC && clock != GPR_CLOCK_REALTIME &&
+      clock != GPR_CLOCK_PRECISE &&
+      (!allow_timespan || clock != GPR_TIMESPAN)) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         allow_timespan ? "Invalid clock type" :
+                         "Clock type must be a clock, not CLOCK_TIMESPAN", 1);
+    return false;
+  }
+  *clock_type = (gpr_clock_type)clock;
+  return true;
+}
+
+/* Parses the optional clock type argument of the static constructors,
+ * which defaults to the realtime clock */
+static bool parse_clock_type(INTERNAL_FUNCTION_PARAMETERS, bool allow_timespan,
+                             gpr_clock_type *clock_type) {
+  zend_long clock = GPR_CLOCK_REALTIME;
+
+  /* "|l" == 1 optional long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "|l", &clock) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Expected an optional clock type", 1);
+    return false;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(0, 1)
+    Z_PARAM_OPTIONAL
+    Z_PARAM_LONG(clock)
+  ZEND_PARSE_PARAMETERS_END_EX(return false);
+#endif
+
+  return read_clock_type(clock, allow_timespan, clock_type);
+}
+
+/* Returns the shared Timeval object holding a constant value. Timeval objects
+ * are immutable, so each value is only allocated once per request */
+static void return_timeval_constant(int value, gpr_clock_type clock_type,
+                                    zval *return_value) {
+  zend_object **cached = &GRPC_G(timeval_constants)[value][clock_type];
+  if (*cached == NULL) {
+    zval timeval;
+    switch (value) {
+      case TIMEVAL_ZERO:
+        grpc_php_wrap_timeval(gpr_time_0(clock_type), &timeval);
+        break;
+      case TIMEVAL_INF_FUTURE:
+        grpc_php_wrap_timeval(gpr_inf_future(clock_type), &timeval);
+        break;
+      default:
+        grpc_php_wrap_timeval(gpr_inf_past(clock_type), &timeval);
+        break;
+    }
+    *cached = Z_OBJ(timeval);
+  }
+  ZVAL_OBJ(return_value, *cached);
+  Z_ADDREF_P(return_value);
+}
+
+/* Makes b comparable to a by converting it to the clock of a. Throws and
+ * returns false if only one of them is a time interval */
+static bool same_clock_type(gpr_timespec a, gpr_timespec *b) {
+  if (a.clock_type == b->clock_type) {
+    return true;
+  }
+  if (a.clock_type == GPR_TIMESPAN || b->clock_type == GPR_TIMESPAN) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Cannot mix a time interval with a point in time",
+                         1);
+    return false;
+  }
+  *b = gpr_convert_clock_type(*b, a.clock_type);
+  return true;
+}
+
 /**
  * Constructs a new instance of the Timeval class
  * @param long $usec The number of microseconds in the interval
@@ -107,8 +228,9 @@ PHP_METHOD(Timeval, __construct) {
 }
 
 /**
- * Adds another Timeval to this one and returns the sum. Calculations saturate
- * at infinities.
+ * Adds another Timeval to this one and returns the sum. One of them must be a
+ * time interval, and the sum has the clock type of the other one.
+ * Calculations saturate at infinities.
  * @param Timeval $other The other Timeval object to add
  * @return Timeval A new Timeval object containing the sum
  */
@@ -131,12 +253,24 @@ PHP_METHOD(Timeval, add) {
 
   wrapped_grpc_timeval *self = Z_WRAPPED_GRPC_TIMEVAL_P(getThis());
   wrapped_grpc_timeval *other = Z_WRAPPED_GRPC_TIMEVAL_P(other_obj);
-  grpc_php_wrap_timeval(gpr_time_add(self->wrapped, other->wrapped), return_value);
+  if (other->wrapped.clock_type == GPR_TIMESPAN) {
+    grpc_php_wrap_timeval(gpr_time_add(self->wrapped, other->wrapped),
+                          return_value);
+  } else if (self->wrapped.clock_type == GPR_TIMESPAN) {
+    grpc_php_wrap_timeval(gpr_time_add(other->wrapped, self->wrapped),
+                          return_value);
+  } else {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Cannot add two points in time", 1);
+    return;
+  }
   RETURN_DESTROY_ZVAL(return_value);
 }
 
 /**
  * Subtracts another Timeval from this one and returns the difference.
+ * Subtracting a time interval keeps the clock type of this Timeval, and
+ * subtracting a point in time yields a time interval.
  * Calculations saturate at infinities.
  * @param Timeval $other The other Timeval object to subtract
  * @param Timeval A new Timeval object containing the sum
@@ -160,14 +294,20 @@ PHP_METHOD(Timeval, subtract) {
 
   wrapped_grpc_timeval *self = Z_WRAPPED_GRPC_TIMEVAL_P(getThis());
   wrapped_grpc_timeval *other = Z_WRAPPED_GRPC_TIMEVAL_P(other_obj);
-  grpc_php_wrap_timeval(gpr_time_sub(self->wrapped, other->wrapped),
+  gpr_timespec other_time = other->wrapped;
+  if (other_time.clock_type != GPR_TIMESPAN &&
+      !same_clock_type(self->wrapped, &other_time)) {
+    return;
+  }
+  grpc_php_wrap_timeval(gpr_time_sub(self->wrapped, other_time),
                         return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
 /**
  * Return negative, 0, or positive according to whether a < b, a == b, or a > b
- * respectively.
+ * respectively. Points in time of different clocks are compared after
+ * converting b to the clock of a.
  * @param Timeval $a The first time to compare
  * @param Timeval $b The second time to compare
  * @return long
@@ -194,7 +334,11 @@ PHP_METHOD(Timeval, compare) {
 
   wrapped_grpc_timeval *a = Z_WRAPPED_GRPC_TIMEVAL_P(a_obj);
   wrapped_grpc_timeval *b = Z_WRAPPED_GRPC_TIMEVAL_P(b_obj);
-  long result = gpr_time_cmp(a->wrapped, b->wrapped);
+  gpr_timespec b_time = b->wrapped;
+  if (!same_clock_type(a->wrapped, &b_time)) {
+    return;
+  }
+  long result = gpr_time_cmp(a->wrapped, b_time);
   RETURN_LONG(result);
 }
 
@@ -230,45 +374,121 @@ PHP_METHOD(Timeval, similar) {
   wrapped_grpc_timeval *a = Z_WRAPPED_GRPC_TIMEVAL_P(a_obj);
   wrapped_grpc_timeval *b = Z_WRAPPED_GRPC_TIMEVAL_P(b_obj);
   wrapped_grpc_timeval *thresh = Z_WRAPPED_GRPC_TIMEVAL_P(thresh_obj);
-  int result = gpr_time_similar(a->wrapped, b->wrapped, thresh->wrapped);
+  gpr_timespec b_time = b->wrapped;
+  if (thresh->wrapped.clock_type != GPR_TIMESPAN) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "similar expects a time interval threshold", 1);
+    return;
+  }
+  if (!same_clock_type(a->wrapped, &b_time)) {
+    return;
+  }
+  int result = gpr_time_similar(a->wrapped, b_time, thresh->wrapped);
   RETURN_BOOL(result);
 }
 
 /**
  * Returns the current time as a timeval object
+ * @param long $clock The clock to read, one of the Grpc\CLOCK_* constants
+ *     other than CLOCK_TIMESPAN (optional, defaults to CLOCK_REALTIME)
  * @return Timeval The current time
  */
 PHP_METHOD(Timeval, now) {
-  grpc_php_wrap_timeval(gpr_now(GPR_CLOCK_REALTIME), return_value);
+  gpr_clock_type clock_type;
+  if (!parse_clock_type(INTERNAL_FUNCTION_PARAM_PASSTHRU, false,
+                        &clock_type)) {
+    return;
+  }
+  grpc_php_wrap_timeval(gpr_now(clock_type), return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
 /**
  * Returns the zero time interval as a timeval object
- * @return Timeval Zero length time interval
+ * @param long $clock One of the Grpc\CLOCK_* constants (optional, defaults to
+ *     CLOCK_REALTIME)
+ * @return Timeval Zero length time interval, shared by the callers in the
+ *                 request
  */
 PHP_METHOD(Timeval, zero) {
-  grpc_php_wrap_timeval(gpr_time_0(GPR_CLOCK_REALTIME), return_value);
-  RETURN_ZVAL(return_value,
-              false, /* Copy original before returning? */
-              true /* Destroy original before returning */);
+  gpr_clock_type clock_type;
+  if (!parse_clock_type(INTERNAL_FUNCTION_PARAM_PASSTHRU, true,
+                        &clock_type)) {
+    return;
+  }
+  return_timeval_constant(TIMEVAL_ZERO, clock_type, return_value);
 }
 
 /**
  * Returns the infinite future time value as a timeval object
- * @return Timeval Infinite future time value
+ * @param long $clock One of the Grpc\CLOCK_* constants (optional, defaults to
+ *     CLOCK_REALTIME)
+ * @return Timeval Infinite future time value, shared by the callers in the
+ *                 request
  */
 PHP_METHOD(Timeval, infFuture) {
-  grpc_php_wrap_timeval(gpr_inf_future(GPR_CLOCK_REALTIME), return_value);
-  RETURN_DESTROY_ZVAL(return_value);
+  gpr_clock_type clock_type;
+  if (!parse_clock_type(INTERNAL_FUNCTION_PARAM_PASSTHRU, true,
+                        &clock_type)) {
+    return;
+  }
+  return_timeval_constant(TIMEVAL_INF_FUTURE, clock_type, return_value);
 }
 
 /**
  * Returns the infinite past time value as a timeval object
- * @return Timeval Infinite past time value
+ * @param long $clock One of the Grpc\CLOCK_* constants (optional, defaults to
+ *     CLOCK_REALTIME)
+ * @return Timeval Infinite past time value, shared by the callers in the
+ *                 request
  */
 PHP_METHOD(Timeval, infPast) {
-  grpc_php_wrap_timeval(gpr_inf_past(GPR_CLOCK_REALTIME), return_value);
+  gpr_clock_type clock_type;
+  if (!parse_clock_type(INTERNAL_FUNCTION_PARAM_PASSTHRU, true,
+                        &clock_type)) {
+    return;
+  }
+  return_timeval_constant(TIMEVAL_INF_PAST, clock_type, return_value);
+}
+
+/**
+ * Returns the clock this time value is measured on
+ * @return long One of the Grpc\CLOCK_* constants
+ */
+PHP_METHOD(Timeval, getClockType) {
+  wrapped_grpc_timeval *self = Z_WRAPPED_GRPC_TIMEVAL_P(getThis());
+  RETURN_LONG(self->wrapped.clock_type);
+}
+
+/**
+ * Converts this time value to another clock. Converting a point in time to
+ * CLOCK_TIMESPAN yields the interval from now, and the other way around.
+ * @param long $clock One of the Grpc\CLOCK_* constants
+ * @return Timeval A new Timeval object measured on $clock
+ */
+PHP_METHOD(Timeval, convert) {
+  zend_long clock;
+  gpr_clock_type clock_type;
+
+  /* "l" == 1 long */
+#ifndef FAST_ZPP
+  if (zend_parse_parameters(ZEND_NUM_ARGS(), "l", &clock) == FAILURE) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "convert expects a clock type", 1);
+    return;
+  }
+#else
+  ZEND_PARSE_PARAMETERS_START(1, 1)
+    Z_PARAM_LONG(clock)
+  ZEND_PARSE_PARAMETERS_END();
+#endif
+
+  if (!read_clock_type(clock, true, &clock_type)) {
+    return;
+  }
+  wrapped_grpc_timeval *self = Z_WRAPPED_GRPC_TIMEVAL_P(getThis());
+  grpc_php_wrap_timeval(gpr_convert_clock_type(self->wrapped, clock_type),
+                        return_value);
   RETURN_DESTROY_ZVAL(return_value);
 }
 
@@ -278,6 +498,11 @@ PHP_METHOD(Timeval, infPast) {
  */
 PHP_METHOD(Timeval, sleepUntil) {
   wrapped_grpc_timeval *this = Z_WRAPPED_GRPC_TIMEVAL_P(getThis());
+  if (this->wrapped.clock_type == GPR_TIMESPAN) {
+    zend_throw_exception(spl_ce_InvalidArgumentException,
+                         "Cannot sleep until a time interval", 1);
+    return;
+  }
   gpr_sleep_until(this->wrapped);
 }
 
@@ -285,6 +510,8 @@ static zend_function_entry timeval_methods[] = {
     PHP_ME(Timeval, __construct, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_CTOR)
     PHP_ME(Timeval, add, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Timeval, compare, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
+    PHP_ME(Timeval, convert, NULL, ZEND_ACC_PUBLIC)
+    PHP_ME(Timeval, getClockType, NULL, ZEND_ACC_PUBLIC)
     PHP_ME(Timeval, infFuture, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Timeval, infPast, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
     PHP_ME(Timeval, now, NULL, ZEND_ACC_PUBLIC | ZEND_ACC_STATIC)
@@ -305,7 +532,24 @@ void grpc_init_timeval() {
   timeval_object_handlers_timeval.offset =
     XtOffsetOf(wrapped_grpc_timeval, std);
   timeval_object_handlers_timeval.free_obj = free_wrapped_grpc_timeval;
+  timeval_object_handlers_timeval.write_property = timeval_write_property;
+  timeval_object_handlers_timeval.get_property_ptr_ptr =
+    timeval_get_property_ptr_ptr;
 }
 
 void grpc_shutdown_timeval() {
 }
+
+void grpc_rshutdown_timeval() {
+  int value;
+  int clock_type;
+  for (value = 0; value < GRPC_PHP_TIMEVAL_CONSTANTS; value++) {
+    for (clock_type = 0; clock_type < GRPC_PHP_CLOCK_TYPES; clock_type++) {
+      zend_object **cached = &GRPC_G(timeval_constants)[value][clock_type];
+      if (*cached != NULL) {
+        OBJ_RELEASE(*cached);
+        *cached = NULL;
+      }
+    }
+  }
+}
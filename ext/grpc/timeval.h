@@ -70,6 +70,9 @@ void grpc_init_timeval();
 /* Shutdown the Timeval PHP class */
 void grpc_shutdown_timeval();
 
+/* Releases the constant Timeval objects shared during the request */
+void grpc_rshutdown_timeval();
+
 /* Creates a Timeval object that wraps the given timeval struct */
 void grpc_php_wrap_timeval(gpr_timespec wrapped, zval *timeval_object);
 
@@ -43,27 +43,37 @@ abstract class AbstractCall
     /**
      * Create a new Call wrapper object.
      *
-     * @param Channel  $channel     The channel to communicate on
-     * @param string   $method      The method to call on the
-     *                              remote server
-     * @param callback $deserialize A callback function to deserialize
-     *                              the response
-     * @param array    $options     Call options (optional)
+     * @param Channel|ChannelPool $channel     The channel to communicate on
+     * @param string              $method      The method to call on the
+     *                                         remote server
+     * @param callback            $deserialize A callback function to
+     *                                         deserialize the response
+     * @param array               $options     Call options (optional):
+     *                                         'timeout' in microseconds,
+     *                                         'call_credentials_callback',
+     *                                         and 'parent_call', the server
+     *                                         Call to propagate the deadline
+     *                                         and cancellation from
      */
-    public function __construct(Channel $channel,
+    public function __construct($channel,
                                 $method,
                                 $deserialize,
                                 $options = [])
     {
+        // The extension turns a timeout in microseconds into a deadline
         if (isset($options['timeout']) &&
             is_numeric($timeout = $options['timeout'])) {
-            $now = Timeval::now();
-            $delta = new Timeval($timeout);
-            $deadline = $now->add($delta);
+            $timeout = (int) $timeout;
         } else {
-            $deadline = Timeval::infFuture();
+            $timeout = null;
         }
-        $this->call = new Call($channel, $method, $deadline);
+        // Without a parent call, the extension uses the server context
+        $parent_call = isset($options['parent_call']) ?
+            $options['parent_call'] : null;
+        $this->call = new Call($channel, $method, $timeout, null,
+                               $parent_call);
+        // Received messages come back from the extension deserialized
+        $this->call->setDeserializer($deserialize);
         $this->deserialize = $deserialize;
         $this->metadata = null;
         if (isset($options['call_credentials_callback']) &&
@@ -45,19 +45,34 @@ class BaseStub
 
     // a callback function
     private $update_metadata;
+    // seconds an update_metadata result is reused for, 0 to never reuse it
+    private $update_metadata_ttl;
+    // update_metadata results by audience: [input, metadata, expiry]
+    private $metadata_cache = [];
+    // audience URIs by method name
+    private $jwt_aud_uris = [];
 
     /**
      * @param $hostname string
      * @param $opts array
      *  - 'update_metadata': (optional) a callback function which takes in a
      * metadata array, and returns an updated metadata array
+     *  - 'update_metadata_ttl': (optional) the number of seconds the result
+     * of update_metadata is reused for calls with the same audience and
+     * metadata, 0 by default
      *  - 'grpc.primary_user_agent': (optional) a user-agent string
+     *  - 'channel_pool_size': (optional) the number of connections to spread
+     * the calls of this stub over, using a ChannelPool
      */
     public function __construct($hostname, $opts)
     {
-        $ssl_roots = file_get_contents(
-            dirname(__FILE__).'../../../../etc/roots.pem');
-        ChannelCredentials::setDefaultRootsPem($ssl_roots);
+        // The default roots are kept by the extension for the lifetime of
+        // the process, so they only need to be read once per worker.
+        if (!ChannelCredentials::isDefaultRootsPemSet()) {
+            $ssl_roots = file_get_contents(
+                dirname(__FILE__).'../../../../etc/roots.pem');
+            ChannelCredentials::setDefaultRootsPem($ssl_roots);
+        }
 
         $this->hostname = $hostname;
         $this->update_metadata = null;
@@ -67,6 +82,11 @@ class BaseStub
             }
             unset($opts['update_metadata']);
         }
+        $this->update_metadata_ttl = 0;
+        if (isset($opts['update_metadata_ttl'])) {
+            $this->update_metadata_ttl = (float) $opts['update_metadata_ttl'];
+            unset($opts['update_metadata_ttl']);
+        }
         $package_config = json_decode(
             file_get_contents(dirname(__FILE__).'/../../composer.json'), true);
         if (!empty($opts['grpc.primary_user_agent'])) {
@@ -81,7 +101,16 @@ class BaseStub
                                  'required. Please see one of the '.
                                  'ChannelCredentials::create methods');
         }
-        $this->channel = new Channel($hostname, $opts);
+        $pool_size = 1;
+        if (isset($opts['channel_pool_size'])) {
+            $pool_size = $opts['channel_pool_size'];
+            unset($opts['channel_pool_size']);
+        }
+        if ($pool_size > 1) {
+            $this->channel = new ChannelPool($hostname, $opts, $pool_size);
+        } else {
+            $this->channel = new Channel($hostname, $opts);
+        }
     }
 
     /**
@@ -110,38 +139,7 @@ class BaseStub
      */
     public function waitForReady($timeout)
     {
-        $new_state = $this->getConnectivityState(true);
-        if ($this->_checkConnectivityState($new_state)) {
-            return true;
-        }
-
-        $now = Timeval::now();
-        $delta = new Timeval($timeout);
-        $deadline = $now->add($delta);
-
-        while ($this->channel->watchConnectivityState($new_state, $deadline)) {
-            // state has changed before deadline
-            $new_state = $this->getConnectivityState();
-            if ($this->_checkConnectivityState($new_state)) {
-                return true;
-            }
-        }
-        // deadline has passed
-        $new_state = $this->getConnectivityState();
-
-        return $this->_checkConnectivityState($new_state);
-    }
-
-    private function _checkConnectivityState($new_state)
-    {
-        if ($new_state == \Grpc\CHANNEL_READY) {
-            return true;
-        }
-        if ($new_state == \Grpc\CHANNEL_FATAL_FAILURE) {
-            throw new \Exception('Failed to connect to server');
-        }
-
-        return false;
+        return $this->channel->waitForReady($timeout);
     }
 
     /**
@@ -157,6 +155,9 @@ class BaseStub
      */
     private function _get_jwt_aud_uri($method)
     {
+        if (isset($this->jwt_aud_uris[$method])) {
+            return $this->jwt_aud_uris[$method];
+        }
         $last_slash_idx = strrpos($method, '/');
         if ($last_slash_idx === false) {
             throw new \InvalidArgumentException(
@@ -164,30 +165,45 @@ class BaseStub
         }
         $service_name = substr($method, 0, $last_slash_idx);
 
-        return 'https://'.$this->hostname.$service_name;
+        return $this->jwt_aud_uris[$method] =
+            'https://'.$this->hostname.$service_name;
     }
 
     /**
-     * validate and normalize the metadata array.
+     * Runs update_metadata for a call and validates the result. The result
+     * is reused for update_metadata_ttl seconds when the same metadata is
+     * sent to the same audience.
      *
-     * @param $metadata The metadata map
+     * @param string $method   The name of the method to call
+     * @param array  $metadata The metadata map of the call
      *
-     * @return $metadata Validated and key-normalized metadata map
-     * @throw InvalidArgumentException if key contains invalid characters
+     * @return array The metadata map to send to the server
      */
-    private function _validate_and_normalize_metadata($metadata)
+    private function _update_metadata($method, $metadata)
     {
-        $metadata_copy = [];
-        foreach ($metadata as $key => $value) {
-            if (!preg_match('/^[A-Za-z\d_-]+$/', $key)) {
-                throw new \InvalidArgumentException(
-                    'Metadata keys must be nonempty strings containing only '.
-                    'alphanumeric characters, hyphens and underscores');
+        $jwt_aud_uri = $this->_get_jwt_aud_uri($method);
+        if (!is_callable($this->update_metadata)) {
+            return Metadata::normalize($metadata);
+        }
+        if ($this->update_metadata_ttl > 0) {
+            $now = microtime(true);
+            if (isset($this->metadata_cache[$jwt_aud_uri])) {
+                list($input, $cached, $expiry) =
+                    $this->metadata_cache[$jwt_aud_uri];
+                if ($now < $expiry && $input === $metadata) {
+                    return $cached;
+                }
             }
-            $metadata_copy[strtolower($key)] = $value;
+        }
+        $updated = Metadata::normalize(call_user_func($this->update_metadata,
+                                                      $metadata,
+                                                      $jwt_aud_uri));
+        if ($this->update_metadata_ttl > 0) {
+            $this->metadata_cache[$jwt_aud_uri] =
+                [$metadata, $updated, $now + $this->update_metadata_ttl];
         }
 
-        return $metadata_copy;
+        return $updated;
     }
 
     /* This class is intended to be subclassed by generated code, so
@@ -214,14 +230,7 @@ class BaseStub
                               $method,
                               $deserialize,
                               $options);
-        $jwt_aud_uri = $this->_get_jwt_aud_uri($method);
-        if (is_callable($this->update_metadata)) {
-            $metadata = call_user_func($this->update_metadata,
-                                        $metadata,
-                                        $jwt_aud_uri);
-        }
-        $metadata = $this->_validate_and_normalize_metadata(
-            $metadata);
+        $metadata = $this->_update_metadata($method, $metadata);
         $call->start($argument, $metadata, $options);
 
         return $call;
@@ -248,14 +257,7 @@ class BaseStub
                                         $method,
                                         $deserialize,
                                         $options);
-        $jwt_aud_uri = $this->_get_jwt_aud_uri($method);
-        if (is_callable($this->update_metadata)) {
-            $metadata = call_user_func($this->update_metadata,
-                                        $metadata,
-                                        $jwt_aud_uri);
-        }
-        $metadata = $this->_validate_and_normalize_metadata(
-            $metadata);
+        $metadata = $this->_update_metadata($method, $metadata);
         $call->start($metadata);
 
         return $call;
@@ -282,14 +284,7 @@ class BaseStub
                                         $method,
                                         $deserialize,
                                         $options);
-        $jwt_aud_uri = $this->_get_jwt_aud_uri($method);
-        if (is_callable($this->update_metadata)) {
-            $metadata = call_user_func($this->update_metadata,
-                                        $metadata,
-                                        $jwt_aud_uri);
-        }
-        $metadata = $this->_validate_and_normalize_metadata(
-            $metadata);
+        $metadata = $this->_update_metadata($method, $metadata);
         $call->start($argument, $metadata, $options);
 
         return $call;
@@ -313,14 +308,7 @@ class BaseStub
                                       $method,
                                       $deserialize,
                                       $options);
-        $jwt_aud_uri = $this->_get_jwt_aud_uri($method);
-        if (is_callable($this->update_metadata)) {
-            $metadata = call_user_func($this->update_metadata,
-                                        $metadata,
-                                        $jwt_aud_uri);
-        }
-        $metadata = $this->_validate_and_normalize_metadata(
-            $metadata);
+        $metadata = $this->_update_metadata($method, $metadata);
         $call->start($metadata);
 
         return $call;
@@ -47,9 +47,11 @@ class BidiStreamingCall extends AbstractCall
      */
     public function start($metadata = [])
     {
-        $this->call->startBatch([
-            OP_SEND_INITIAL_METADATA => $metadata,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_SEND_INITIAL_METADATA]);
+        }
+        $template->execute($this->call, $metadata);
     }
 
     /**
@@ -59,16 +61,23 @@ class BidiStreamingCall extends AbstractCall
      */
     public function read()
     {
-        $batch = [OP_RECV_MESSAGE => true];
-        if ($this->metadata === null) {
-            $batch[OP_RECV_INITIAL_METADATA] = true;
+        static $first_read = null;
+        static $read = null;
+        if ($read === null) {
+            $first_read = new BatchTemplate([
+                OP_RECV_MESSAGE,
+                OP_RECV_INITIAL_METADATA,
+            ]);
+            $read = new BatchTemplate([OP_RECV_MESSAGE]);
         }
-        $read_event = $this->call->startBatch($batch);
         if ($this->metadata === null) {
+            $read_event = $first_read->execute($this->call);
             $this->metadata = $read_event->metadata;
+        } else {
+            $read_event = $read->execute($this->call);
         }
 
-        return $this->deserializeResponse($read_event->message);
+        return $read_event->message;
     }
 
     /**
@@ -81,13 +90,12 @@ class BidiStreamingCall extends AbstractCall
      */
     public function write($data, $options = [])
     {
-        $message_array = ['message' => $data->serialize()];
-        if (isset($options['flags'])) {
-            $message_array['flags'] = $options['flags'];
+        static $templates = [];
+        $flags = isset($options['flags']) ? $options['flags'] : 0;
+        if (!isset($templates[$flags])) {
+            $templates[$flags] = new BatchTemplate([OP_SEND_MESSAGE], $flags);
         }
-        $this->call->startBatch([
-            OP_SEND_MESSAGE => $message_array,
-        ]);
+        $templates[$flags]->execute($this->call, $data->serialize());
     }
 
     /**
@@ -95,9 +103,11 @@ class BidiStreamingCall extends AbstractCall
      */
     public function writesDone()
     {
-        $this->call->startBatch([
-            OP_SEND_CLOSE_FROM_CLIENT => true,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_SEND_CLOSE_FROM_CLIENT]);
+        }
+        $template->execute($this->call);
     }
 
     /**
@@ -108,9 +118,11 @@ class BidiStreamingCall extends AbstractCall
      */
     public function getStatus()
     {
-        $status_event = $this->call->startBatch([
-            OP_RECV_STATUS_ON_CLIENT => true,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_RECV_STATUS_ON_CLIENT]);
+        }
+        $status_event = $template->execute($this->call);
 
         return $status_event->status;
     }
@@ -47,9 +47,11 @@ class ClientStreamingCall extends AbstractCall
      */
     public function start($metadata = [])
     {
-        $this->call->startBatch([
-            OP_SEND_INITIAL_METADATA => $metadata,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_SEND_INITIAL_METADATA]);
+        }
+        $template->execute($this->call, $metadata);
     }
 
     /**
@@ -62,13 +64,12 @@ class ClientStreamingCall extends AbstractCall
      */
     public function write($data, $options = [])
     {
-        $message_array = ['message' => $data->serialize()];
-        if (isset($options['flags'])) {
-            $message_array['flags'] = $options['flags'];
+        static $templates = [];
+        $flags = isset($options['flags']) ? $options['flags'] : 0;
+        if (!isset($templates[$flags])) {
+            $templates[$flags] = new BatchTemplate([OP_SEND_MESSAGE], $flags);
         }
-        $this->call->startBatch([
-            OP_SEND_MESSAGE => $message_array,
-        ]);
+        $templates[$flags]->execute($this->call, $data->serialize());
     }
 
     /**
@@ -78,14 +79,18 @@ class ClientStreamingCall extends AbstractCall
      */
     public function wait()
     {
-        $event = $this->call->startBatch([
-            OP_SEND_CLOSE_FROM_CLIENT => true,
-            OP_RECV_INITIAL_METADATA => true,
-            OP_RECV_MESSAGE => true,
-            OP_RECV_STATUS_ON_CLIENT => true,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([
+                OP_SEND_CLOSE_FROM_CLIENT,
+                OP_RECV_INITIAL_METADATA,
+                OP_RECV_MESSAGE,
+                OP_RECV_STATUS_ON_CLIENT,
+            ]);
+        }
+        $event = $template->execute($this->call);
         $this->metadata = $event->metadata;
 
-        return [$this->deserializeResponse($event->message), $event->status];
+        return [$event->message, $event->status];
     }
 }
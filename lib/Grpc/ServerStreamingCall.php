@@ -50,16 +50,18 @@ class ServerStreamingCall extends AbstractCall
      */
     public function start($data, $metadata = [], $options = [])
     {
-        $message_array = ['message' => $data->serialize()];
-        if (isset($options['flags'])) {
-            $message_array['flags'] = $options['flags'];
+        static $templates = [];
+        $flags = isset($options['flags']) ? $options['flags'] : 0;
+        if (!isset($templates[$flags])) {
+            $templates[$flags] = new BatchTemplate([
+                OP_SEND_INITIAL_METADATA,
+                OP_RECV_INITIAL_METADATA,
+                OP_SEND_MESSAGE,
+                OP_SEND_CLOSE_FROM_CLIENT,
+            ], $flags);
         }
-        $event = $this->call->startBatch([
-            OP_SEND_INITIAL_METADATA => $metadata,
-            OP_RECV_INITIAL_METADATA => true,
-            OP_SEND_MESSAGE => $message_array,
-            OP_SEND_CLOSE_FROM_CLIENT => true,
-        ]);
+        $event = $templates[$flags]->execute($this->call, $metadata,
+                                             $data->serialize());
         $this->metadata = $event->metadata;
     }
 
@@ -68,14 +70,14 @@ class ServerStreamingCall extends AbstractCall
      */
     public function responses()
     {
-        $response = $this->call->startBatch([
-            OP_RECV_MESSAGE => true,
-        ])->message;
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_RECV_MESSAGE]);
+        }
+        $response = $template->execute($this->call)->message;
         while ($response !== null) {
-            yield $this->deserializeResponse($response);
-            $response = $this->call->startBatch([
-                OP_RECV_MESSAGE => true,
-            ])->message;
+            yield $response;
+            $response = $template->execute($this->call)->message;
         }
     }
 
@@ -87,9 +89,11 @@ class ServerStreamingCall extends AbstractCall
      */
     public function getStatus()
     {
-        $status_event = $this->call->startBatch([
-            OP_RECV_STATUS_ON_CLIENT => true,
-        ]);
+        static $template = null;
+        if ($template === null) {
+            $template = new BatchTemplate([OP_RECV_STATUS_ON_CLIENT]);
+        }
+        $status_event = $template->execute($this->call);
 
         return $status_event->status;
     }
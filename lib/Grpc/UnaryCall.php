@@ -36,10 +36,66 @@ namespace Grpc;
 
 /**
  * Represents an active call that sends a single message and then gets a single
- * response.
+ * response. start() sends the whole RPC as a single batch, and wait() waits
+ * for it to complete. With the 'blocking' option, the RPC is instead made by
+ * a single Call::unary() when its result is first needed, which saves the
+ * Call object but sends nothing until then.
  */
 class UnaryCall extends AbstractCall
 {
+    // The arguments of Call::unary() for a blocking call, otherwise null
+    private $unary;
+    // The result of the batch of the call once it has completed
+    private $event;
+
+    /**
+     * Create a new UnaryCall wrapper object.
+     *
+     * @param Channel|ChannelPool $channel     The channel to communicate on
+     * @param string              $method      The method to call on the
+     *                                         remote server
+     * @param callback            $deserialize A callback function to
+     *                                         deserialize the response
+     * @param array               $options     Call options (optional), as
+     *                                         for AbstractCall, and
+     *                                         'blocking' to make the call
+     *                                         with Call::unary()
+     */
+    public function __construct($channel,
+                                $method,
+                                $deserialize,
+                                $options = [])
+    {
+        if (empty($options['blocking'])) {
+            parent::__construct($channel, $method, $deserialize, $options);
+
+            return;
+        }
+        // No Call object is needed until the result is
+        $this->deserialize = $deserialize;
+        $this->metadata = null;
+        $this->unary = [
+            'channel' => $channel,
+            'method' => $method,
+            'timeout' => null,
+            'call_credentials' => null,
+            'parent_call' => isset($options['parent_call']) ?
+                $options['parent_call'] : null,
+            'cancelled' => false,
+            'request' => null,
+        ];
+        if (isset($options['timeout']) &&
+            is_numeric($timeout = $options['timeout'])) {
+            $this->unary['timeout'] = (int) $timeout;
+        }
+        if (isset($options['call_credentials_callback']) &&
+            is_callable($call_credentials_callback =
+                        $options['call_credentials_callback'])) {
+            $this->unary['call_credentials'] =
+                CallCredentials::createFromPlugin($call_credentials_callback);
+        }
+    }
+
     /**
      * Start the call.
      *
@@ -50,17 +106,25 @@ class UnaryCall extends AbstractCall
      */
     public function start($data, $metadata = [], $options = [])
     {
-        $message_array = ['message' => $data->serialize()];
-        if (isset($options['flags'])) {
-            $message_array['flags'] = $options['flags'];
+        $flags = isset($options['flags']) ? $options['flags'] : 0;
+        if ($this->unary !== null) {
+            $this->unary['request'] = $data->serialize();
+            $this->unary['metadata'] = $metadata;
+            $this->unary['flags'] = $flags;
+
+            return;
         }
-        $event = $this->call->startBatch([
+        $this->call->startBatchAsync([
             OP_SEND_INITIAL_METADATA => $metadata,
             OP_RECV_INITIAL_METADATA => true,
-            OP_SEND_MESSAGE => $message_array,
+            OP_SEND_MESSAGE => [
+                'message' => $data->serialize(),
+                'flags' => $flags,
+            ],
             OP_SEND_CLOSE_FROM_CLIENT => true,
+            OP_RECV_MESSAGE => true,
+            OP_RECV_STATUS_ON_CLIENT => true,
         ]);
-        $this->metadata = $event->metadata;
     }
 
     /**
@@ -70,11 +134,107 @@ class UnaryCall extends AbstractCall
      */
     public function wait()
     {
-        $event = $this->call->startBatch([
-            OP_RECV_MESSAGE => true,
-            OP_RECV_STATUS_ON_CLIENT => true,
-        ]);
+        $this->finish();
+        // The Call deserializes the response itself
+        $response = $this->unary === null ? $this->event->message :
+            $this->deserializeResponse($this->event->message);
+
+        return [$response, $this->event->status];
+    }
+
+    /**
+     * @return The metadata sent by the server. Waits for the call to
+     *         complete, as it is received in the same batch as the response
+     */
+    public function getMetadata()
+    {
+        $this->finish();
+
+        return $this->metadata;
+    }
+
+    /**
+     * @return string The URI of the endpoint, or the target of the channel
+     *                for a blocking call
+     */
+    public function getPeer()
+    {
+        if ($this->unary !== null) {
+            return $this->unary['channel']->getTarget();
+        }
+
+        return parent::getPeer();
+    }
+
+    /**
+     * Cancels the call. A blocking call can only be cancelled before its
+     * response has been waited for.
+     */
+    public function cancel()
+    {
+        if ($this->unary !== null) {
+            $this->unary['cancelled'] = true;
+
+            return;
+        }
+        parent::cancel();
+    }
+
+    /**
+     * Set the CallCredentials for the call.
+     *
+     * @param CallCredentials $call_credentials The CallCredentials
+     *                                          object
+     */
+    public function setCallCredentials($call_credentials)
+    {
+        if ($this->unary !== null) {
+            $this->unary['call_credentials'] = $call_credentials;
+
+            return;
+        }
+        parent::setCallCredentials($call_credentials);
+    }
+
+    /**
+     * Wait for the batch of the call to complete, or make a blocking call,
+     * unless it has already been done.
+     */
+    private function finish()
+    {
+        if ($this->event !== null) {
+            return;
+        }
+        if ($this->unary === null) {
+            $this->event = $this->call->finishBatch();
+            $this->metadata = $this->event->metadata;
 
-        return [$this->deserializeResponse($event->message), $event->status];
+            return;
+        }
+        if ($this->unary['request'] === null) {
+            throw new \LogicException('The call has not been started');
+        }
+        if ($this->unary['cancelled']) {
+            $this->metadata = [];
+            $this->event = (object) [
+                'message' => null,
+                'status' => (object) [
+                    'metadata' => [],
+                    'code' => STATUS_CANCELLED,
+                    'details' => 'Cancelled',
+                ],
+            ];
+
+            return;
+        }
+        $unary = $this->unary;
+        list($message, $status, $this->metadata) = Call::unary(
+            $unary['channel'], $unary['method'], $unary['request'],
+            $unary['metadata'], $unary['timeout'], $unary['flags'],
+            $unary['call_credentials'], $unary['parent_call']);
+        $this->event = (object) [
+            'message' => $message,
+            'status' => $status,
+        ];
     }
 }
@@ -0,0 +1,75 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Measures the conversions of the extension between PHP values and grpc
+ * structs on payloads from 16 B to 16 MB, and prints the results as JSON.
+ * It needs the extension built with --enable-grpc-bench:
+ *   make bench [BENCH_ARGS="--case=<name> --max-size=<bytes>"]
+ * or bin/run_benchmarks.sh with the same arguments.
+ */
+
+if (!class_exists('Grpc\Bench')) {
+    fwrite(STDERR, "The grpc extension was built without --enable-grpc-bench\n");
+    exit(1);
+}
+
+$options = getopt('', ['case:', 'max-size:']);
+$cases = isset($options['case']) ? [$options['case']] : Grpc\Bench::cases();
+$max_size = isset($options['max-size']) ? (int) $options['max-size']
+                                        : 16 * 1024 * 1024;
+
+$results = [];
+foreach ($cases as $case) {
+    // A timeval has no payload
+    $sizes = $case === 'timeval' ? [0] : [];
+    for ($size = 16; $size <= $max_size && $case !== 'timeval'; $size *= 4) {
+        $sizes[] = $size;
+    }
+    foreach ($sizes as $size) {
+        // About 64 MB of payload per run, at least 10 iterations
+        $iterations = max(10, min(100000, intdiv(64 * 1024 * 1024,
+                                                 max($size, 1))));
+        $results[] = [
+            'case' => $case,
+            'size' => $size,
+            'iterations' => $iterations,
+        ] + Grpc\Bench::run($case, $size, $iterations);
+    }
+}
+
+echo json_encode([
+    'php' => PHP_VERSION,
+    'results' => $results,
+], JSON_PRETTY_PRINT), "\n";
@@ -0,0 +1,75 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Compares Grpc\Metadata::normalize with the PHP metadata validation that
+ * BaseStub used before it:
+ *   php -d extension=grpc.so tests/benchmark/metadata_normalize.php [n]
+ */
+
+function normalize_in_php($metadata)
+{
+    $metadata_copy = [];
+    foreach ($metadata as $key => $value) {
+        if (!preg_match('/^[A-Za-z\d_-]+$/', $key)) {
+            throw new \InvalidArgumentException(
+                'Metadata keys must be nonempty strings containing only '.
+                'alphanumeric characters, hyphens and underscores');
+        }
+        $metadata_copy[strtolower($key)] = $value;
+    }
+
+    return $metadata_copy;
+}
+
+function bench($name, $normalize, $metadata, $iterations)
+{
+    $start = microtime(true);
+    for ($i = 0; $i < $iterations; ++$i) {
+        $normalize($metadata);
+    }
+    $elapsed = microtime(true) - $start;
+    printf("%-8s %8.1f ns/call\n", $name, $elapsed * 1e9 / $iterations);
+}
+
+$iterations = isset($argv[1]) ? (int) $argv[1] : 1000000;
+$metadata = [
+    'Authorization' => ['Bearer abcdefghijklmnopqrstuvwxyz0123456789'],
+    'x-goog-api-client' => ['gl-php/7.0.0 grpc/1.0.0'],
+    'X-Request-Id' => ['0123456789abcdef'],
+    'trace-bin' => ["\x00\x01\x02\x03"],
+];
+
+bench('php', 'normalize_in_php', $metadata, $iterations);
+bench('native', 'Grpc\Metadata::normalize', $metadata, $iterations);
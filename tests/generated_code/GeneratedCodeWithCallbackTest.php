@@ -54,4 +54,30 @@ class GeneratedCodeWithCallbackTest extends AbstractGeneratedCodeTest
     {
         self::$client->close();
     }
+
+    public function testUpdateMetadataTtl()
+    {
+        $updates = 0;
+        $client = new math\MathClient(
+        getenv('GRPC_TEST_HOST'),
+        ['credentials' => Grpc\ChannelCredentials::createInsecure(),
+         'update_metadata' => function ($a_hash,
+                                        $client = []) use (&$updates) {
+                                ++$updates;
+                                $a_copy = $a_hash;
+                                $a_copy['foo'] = ['bar'];
+
+                                return $a_copy;
+            },
+         'update_metadata_ttl' => 60,
+        ]);
+        $div_arg = new math\DivArgs();
+        $client->Div($div_arg);
+        $client->Div($div_arg);
+        $this->assertSame(1, $updates);
+        // Different metadata is not served from the cache
+        $client->Div($div_arg, ['key' => ['value']]);
+        $this->assertSame(2, $updates);
+        $client->close();
+    }
 }
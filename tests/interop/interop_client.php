@@ -388,19 +388,249 @@ function timeoutOnSleepingServer($stub)
              'Call status was not DEADLINE_EXCEEDED');
 }
 
+/**
+ * Run a test case.
+ *
+ * @param $stub Stub object that has service methods
+ * @param $test_case The name of the test case
+ * @param $args array command line args
+ */
+function runTestCase($stub, $test_case, $args)
+{
+    switch ($test_case) {
+        case 'empty_unary':
+            emptyUnary($stub);
+            break;
+        case 'large_unary':
+            largeUnary($stub);
+            break;
+        case 'client_streaming':
+            clientStreaming($stub);
+            break;
+        case 'server_streaming':
+            serverStreaming($stub);
+            break;
+        case 'ping_pong':
+            pingPong($stub);
+            break;
+        case 'empty_stream':
+            emptyStream($stub);
+            break;
+        case 'cancel_after_begin':
+            cancelAfterBegin($stub);
+            break;
+        case 'cancel_after_first_response':
+            cancelAfterFirstResponse($stub);
+            break;
+        case 'timeout_on_sleeping_server':
+            timeoutOnSleepingServer($stub);
+            break;
+        case 'service_account_creds':
+            serviceAccountCreds($stub, $args);
+            break;
+        case 'compute_engine_creds':
+            computeEngineCreds($stub, $args);
+            break;
+        case 'jwt_token_creds':
+            jwtTokenCreds($stub, $args);
+            break;
+        case 'oauth2_auth_token':
+            oauth2AuthToken($stub, $args);
+            break;
+        case 'per_rpc_creds':
+            perRpcCreds($stub, $args);
+            break;
+        default:
+            echo "Unsupported test case $test_case\n";
+            exit(1);
+    }
+}
+
+/**
+ * The test cases that can be run with --load.
+ */
+function loadTestCases()
+{
+    return ['empty_unary', 'large_unary', 'client_streaming',
+            'server_streaming', 'ping_pong', 'empty_stream',
+            'cancel_after_begin', 'cancel_after_first_response', ];
+}
+
+/**
+ * Returns the command line that runs a script of this directory in another
+ * process, with the extension loaded the same way.
+ *
+ * @param $script The name of the script
+ * @param $args array command line args
+ */
+function childCommand($script, $args)
+{
+    $command = 'exec '.escapeshellarg(PHP_BINARY).' -n'.
+        ' -d extension_dir='.escapeshellarg(ini_get('extension_dir')).
+        ' -d extension=grpc.so '.
+        escapeshellarg(dirname(__FILE__).'/'.$script);
+    foreach ($args as $name => $value) {
+        $command .= ' --'.$name.($value === false ? '' :
+                                 '='.escapeshellarg($value));
+    }
+
+    return $command;
+}
+
+/**
+ * Returns the latency under which a fraction of the sorted latencies are.
+ */
+function percentile($sorted, $fraction)
+{
+    return $sorted[min(count($sorted) - 1,
+                       (int) floor(count($sorted) * $fraction))];
+}
+
+/**
+ * Run the test cases over and over for the duration or number of
+ * iterations, then print the latencies of each test case as JSON.
+ *
+ * @param $stub Stub object that has service methods
+ * @param $test_cases The names of the test cases
+ * @param $args array command line args
+ */
+function runLoadWorker($stub, $test_cases, $args)
+{
+    $latencies = array_fill_keys($test_cases, []);
+    $end = isset($args['duration']) ? microtime(true) + $args['duration']
+                                     : INF;
+    $iterations = isset($args['iterations']) ? (int) $args['iterations']
+                                             : PHP_INT_MAX;
+    for ($i = 0; $i < $iterations && microtime(true) < $end; ++$i) {
+        foreach ($test_cases as $test_case) {
+            $start = microtime(true);
+            runTestCase($stub, $test_case, $args);
+            $latencies[$test_case][] = (microtime(true) - $start) * 1e3;
+        }
+    }
+    foreach ($latencies as $test_case => $values) {
+        $latencies[$test_case] = base64_encode(pack('d*', ...$values));
+    }
+    echo json_encode($latencies), "\n";
+}
+
+/**
+ * Run the test cases in several processes, against local stand-in servers
+ * unless a server is given, and print their throughput and latency
+ * percentiles as JSON. Any failed assertion fails the run.
+ *
+ * @param $test_cases The names of the test cases
+ * @param $args array command line args
+ */
+function runLoad($test_cases, $args)
+{
+    $processes = isset($args['processes']) ? (int) $args['processes'] : 4;
+    $worker_args = $args;
+    unset($worker_args['load'], $worker_args['processes']);
+    $worker_args['load_worker'] = false;
+
+    // A stand-in server handles one call at a time, so each worker gets its
+    // own
+    $servers = [];
+    $addresses = [];
+    for ($i = 0; $i < $processes && !isset($args['server_host']); ++$i) {
+        $servers[] = proc_open(childCommand('interop_server.php', []),
+                               [1 => ['pipe', 'w']], $pipes);
+        $addresses[] = explode(':', trim(fgets($pipes[1])));
+    }
+
+    $start = microtime(true);
+    $workers = [];
+    $outputs = [];
+    for ($i = 0; $i < $processes; ++$i) {
+        if (count($addresses) > 0) {
+            list($worker_args['server_host'], $worker_args['server_port']) =
+                $addresses[$i];
+        }
+        $workers[] = proc_open(childCommand('interop_client.php',
+                                            $worker_args),
+                               [1 => ['pipe', 'w']], $pipes);
+        $outputs[] = $pipes[1];
+    }
+
+    $latencies = array_fill_keys($test_cases, []);
+    $failed = false;
+    foreach ($workers as $i => $worker) {
+        $output = stream_get_contents($outputs[$i]);
+        proc_close($worker);
+        $result = json_decode($output, true);
+        if ($result === null) {
+            echo "Load worker $i failed: $output";
+            $failed = true;
+            continue;
+        }
+        foreach ($result as $test_case => $values) {
+            $latencies[$test_case] = array_merge($latencies[$test_case],
+                array_values(unpack('d*', base64_decode($values))));
+        }
+    }
+    $elapsed = microtime(true) - $start;
+    foreach ($servers as $server) {
+        proc_terminate($server);
+        proc_close($server);
+    }
+    if ($failed) {
+        exit(1);
+    }
+
+    $report = [];
+    foreach ($latencies as $test_case => $values) {
+        sort($values);
+        $report[$test_case] = [
+            'calls' => count($values),
+            'qps' => count($values) / $elapsed,
+        ];
+        if (count($values) > 0) {
+            $report[$test_case]['latency_ms'] = [
+                'p50' => percentile($values, 0.5),
+                'p90' => percentile($values, 0.9),
+                'p99' => percentile($values, 0.99),
+                'p999' => percentile($values, 0.999),
+            ];
+        }
+    }
+    echo json_encode($report, JSON_PRETTY_PRINT), "\n";
+}
+
 $args = getopt('', ['server_host:', 'server_port:', 'test_case:',
                     'use_tls::', 'use_test_ca::',
                     'server_host_override:', 'oauth_scope:',
-                    'default_service_account:', ]);
+                    'default_service_account:', 'load', 'processes:',
+                    'duration:', 'iterations:', 'load_worker', ]);
+if (!array_key_exists('iterations', $args)) {
+    $args += ['duration' => 10];
+}
+if (!array_key_exists('test_case', $args)) {
+    throw new Exception('Missing argument: --test_case is required');
+}
+
+// With --load, the comma separated test cases are run repeatedly
+$test_cases = explode(',', $args['test_case']);
+if (array_key_exists('load', $args) ||
+    array_key_exists('load_worker', $args)) {
+    foreach ($test_cases as $test_case) {
+        if (!in_array($test_case, loadTestCases())) {
+            throw new Exception("Test case $test_case cannot be run with ".
+                                '--load');
+        }
+    }
+    if (array_key_exists('load', $args)) {
+        runLoad($test_cases, $args);
+        exit(0);
+    }
+}
+
 if (!array_key_exists('server_host', $args)) {
     throw new Exception('Missing argument: --server_host is required');
 }
 if (!array_key_exists('server_port', $args)) {
     throw new Exception('Missing argument: --server_port is required');
 }
-if (!array_key_exists('test_case', $args)) {
-    throw new Exception('Missing argument: --test_case is required');
-}
 
 if ($args['server_port'] == 443) {
     $server_address = $args['server_host'];
@@ -476,53 +706,12 @@ if ($test_case == 'oauth2_auth_token') {
 
 $stub = new grpc\testing\TestServiceClient($server_address, $opts);
 
+if (array_key_exists('load_worker', $args)) {
+    runLoadWorker($stub, $test_cases, $args);
+    exit(0);
+}
+
 echo "Connecting to $server_address\n";
 echo "Running test case $test_case\n";
 
-switch ($test_case) {
-    case 'empty_unary':
-        emptyUnary($stub);
-        break;
-    case 'large_unary':
-        largeUnary($stub);
-        break;
-    case 'client_streaming':
-        clientStreaming($stub);
-        break;
-    case 'server_streaming':
-        serverStreaming($stub);
-        break;
-    case 'ping_pong':
-        pingPong($stub);
-        break;
-    case 'empty_stream':
-        emptyStream($stub);
-        break;
-    case 'cancel_after_begin':
-        cancelAfterBegin($stub);
-        break;
-    case 'cancel_after_first_response':
-        cancelAfterFirstResponse($stub);
-        break;
-    case 'timeout_on_sleeping_server':
-        timeoutOnSleepingServer($stub);
-        break;
-    case 'service_account_creds':
-        serviceAccountCreds($stub, $args);
-        break;
-    case 'compute_engine_creds':
-        computeEngineCreds($stub, $args);
-        break;
-    case 'jwt_token_creds':
-        jwtTokenCreds($stub, $args);
-        break;
-    case 'oauth2_auth_token':
-        oauth2AuthToken($stub, $args);
-        break;
-    case 'per_rpc_creds':
-        perRpcCreds($stub, $args);
-        break;
-    default:
-        echo "Unsupported test case $test_case\n";
-        exit(1);
-}
+runTestCase($stub, $test_case, $args);
@@ -0,0 +1,157 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * A stand-in for the interop server, which answers the test cases that the
+ * interop client runs with --load. It handles one call at a time:
+ *   php -d extension=grpc.so tests/interop/interop_server.php [--port=<port>]
+ * It prints the address it listens on once it is started.
+ */
+require_once realpath(dirname(__FILE__).'/../../vendor/autoload.php');
+require 'empty.php';
+require 'messages.php';
+
+/**
+ * Returns a payload of the given type and size.
+ */
+function makePayload($type, $size)
+{
+    $payload = new grpc\testing\Payload();
+    $payload->setType($type);
+    $payload->setBody(str_repeat("\0", $size));
+
+    return $payload;
+}
+
+/**
+ * Receives the next message of a server call, or null at the end of the
+ * client's stream.
+ */
+function receive($call)
+{
+    return $call->startBatch([Grpc\OP_RECV_MESSAGE => true])->message;
+}
+
+/**
+ * Sends a message on a server call.
+ */
+function send($call, $message)
+{
+    $call->startBatch([
+        Grpc\OP_SEND_MESSAGE => ['message' => $message->serialize()],
+    ]);
+}
+
+/**
+ * Ends a server call with a status.
+ */
+function finish($call, $code = Grpc\STATUS_OK)
+{
+    $call->startBatch([
+        Grpc\OP_SEND_STATUS_FROM_SERVER => [
+            'metadata' => [],
+            'code' => $code,
+            'details' => '',
+        ],
+        Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+    ]);
+}
+
+/**
+ * Sends the responses a StreamingOutputCallRequest asks for.
+ */
+function sendResponses($call, $request)
+{
+    foreach ($request->getResponseParameters() as $parameters) {
+        $response = new grpc\testing\StreamingOutputCallResponse();
+        $response->setPayload(makePayload($request->getResponseType(),
+                                          $parameters->getSize()));
+        send($call, $response);
+    }
+}
+
+$args = getopt('', ['port:']);
+$port = isset($args['port']) ? $args['port'] : 0;
+$server = new Grpc\Server([]);
+$port = $server->addHttp2Port('127.0.0.1:'.$port);
+$server->start();
+echo "127.0.0.1:$port\n";
+fflush(STDOUT);
+
+while (true) {
+    $event = $server->requestCall();
+    $call = $event->call;
+    $call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => []]);
+    switch ($event->method) {
+        case '/grpc.testing.TestService/EmptyCall':
+            receive($call);
+            send($call, new grpc\testing\EmptyMessage());
+            finish($call);
+            break;
+        case '/grpc.testing.TestService/UnaryCall':
+            $request = grpc\testing\SimpleRequest::decode(receive($call));
+            $response = new grpc\testing\SimpleResponse();
+            $response->setPayload(makePayload($request->getResponseType(),
+                                              $request->getResponseSize()));
+            send($call, $response);
+            finish($call);
+            break;
+        case '/grpc.testing.TestService/StreamingInputCall':
+            $size = 0;
+            while (($message = receive($call)) !== null) {
+                $request =
+                    grpc\testing\StreamingInputCallRequest::decode($message);
+                $size += strlen($request->getPayload()->getBody());
+            }
+            $response = new grpc\testing\StreamingInputCallResponse();
+            $response->setAggregatedPayloadSize($size);
+            send($call, $response);
+            finish($call);
+            break;
+        case '/grpc.testing.TestService/StreamingOutputCall':
+            sendResponses($call, grpc\testing\StreamingOutputCallRequest::decode(
+                receive($call)));
+            finish($call);
+            break;
+        case '/grpc.testing.TestService/FullDuplexCall':
+            while (($message = receive($call)) !== null) {
+                sendResponses($call,
+                    grpc\testing\StreamingOutputCallRequest::decode($message));
+            }
+            finish($call);
+            break;
+        default:
+            finish($call, Grpc\STATUS_UNIMPLEMENTED);
+    }
+}
@@ -0,0 +1,490 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Loopback QPS and latency benchmark of the extension. The driver starts
+ * PHP servers on 127.0.0.1 or on unix sockets, and client processes that
+ * make calls as fast as they can for a while. It then prints the QPS, the
+ * latency percentiles and the CPU time per RPC as JSON:
+ *   bin/run_qps_benchmark.sh --workload=unary --concurrency=8 --payload=1024
+ *
+ * The workloads have the shapes of the methods of the math service of
+ * tests/generated_code, with opaque payloads of the requested size:
+ *   unary             Div, one request and one response
+ *   client_streaming  Sum, stream_length requests and one response
+ *   server_streaming  Fib, one request and stream_length responses
+ *   bidi              DivMany, stream_length requests each answered
+ * --target runs the clients against another server that answers these
+ * methods with payloads, such as a native stand-in, instead of PHP servers.
+ *
+ * --unary_api picks how the unary workload makes its calls, to compare
+ * their CPU time per RPC:
+ *   async        UnaryCall, one batch started by start() and waited for by
+ *                wait()
+ *   blocking     UnaryCall with the 'blocking' option, one Call::unary()
+ *   two_batches  a Call with one startBatch() to send the request and one
+ *                to receive the response, as UnaryCall used to
+ */
+require_once realpath(dirname(__FILE__).'/../../vendor/autoload.php');
+
+$methods = [
+    'unary' => '/math.Math/Div',
+    'client_streaming' => '/math.Math/Sum',
+    'server_streaming' => '/math.Math/Fib',
+    'bidi' => '/math.Math/DivMany',
+];
+
+/**
+ * A message that is serialized as its bytes.
+ */
+class QpsPayload
+{
+    public $data;
+
+    public function __construct($data = '')
+    {
+        $this->data = $data;
+    }
+
+    public function serialize()
+    {
+        return $this->data;
+    }
+
+    public static function decode($data)
+    {
+        return new self($data);
+    }
+}
+
+/**
+ * The CPU time used by this process so far, in microseconds.
+ */
+function cpuTime()
+{
+    $usage = getrusage();
+
+    return $usage['ru_utime.tv_sec'] * 1e6 + $usage['ru_utime.tv_usec'] +
+        $usage['ru_stime.tv_sec'] * 1e6 + $usage['ru_stime.tv_usec'];
+}
+
+/**
+ * The CPU time used so far by another process, in microseconds, or null
+ * where /proc is not available.
+ */
+function processCpuTime($pid)
+{
+    $stat = @file_get_contents("/proc/$pid/stat");
+    if ($stat === false) {
+        return;
+    }
+    // The fields after the command name, which is in parentheses
+    $fields = explode(' ', substr($stat, strrpos($stat, ')') + 2));
+
+    // utime and stime, in clock ticks of 1/100 s on Linux
+    return ($fields[11] + $fields[12]) * 1e4;
+}
+
+/**
+ * The command line that runs this script again in another role, with the
+ * extension loaded the same way.
+ */
+function childCommand($role, $args)
+{
+    $command = 'exec '.escapeshellarg(PHP_BINARY).' -n'.
+        ' -d extension_dir='.escapeshellarg(ini_get('extension_dir')).
+        ' -d extension=grpc.so '.escapeshellarg(__FILE__).
+        ' --role='.$role;
+    unset($args['role']);
+    foreach ($args as $name => $value) {
+        $command .= ' --'.$name.'='.escapeshellarg($value);
+    }
+
+    return $command;
+}
+
+/**
+ * Serve the methods of the workloads until killed.
+ */
+function runServer($args)
+{
+    $server = new Grpc\Server([]);
+    if ($args['transport'] === 'unix') {
+        $address = 'unix:'.$args['socket'];
+        if (!$server->addHttp2Port($address)) {
+            exit(1);
+        }
+    } else {
+        $address = '127.0.0.1:'.$server->addHttp2Port('127.0.0.1:0');
+    }
+    $server->start();
+    echo $address, "\n";
+    fflush(STDOUT);
+
+    $response = str_repeat('x', (int) $args['payload']);
+    $stream_length = (int) $args['stream_length'];
+    $ok = [
+        'metadata' => [],
+        'code' => Grpc\STATUS_OK,
+        'details' => '',
+    ];
+    while (true) {
+        $event = $server->requestCall();
+        $call = $event->call;
+        switch ($event->method) {
+            case '/math.Math/Div':
+                $event = $call->startBatch([
+                    Grpc\OP_SEND_INITIAL_METADATA => [],
+                    Grpc\OP_RECV_MESSAGE => true,
+                ]);
+                $call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $event->message],
+                    Grpc\OP_SEND_STATUS_FROM_SERVER => $ok,
+                    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+                ]);
+                break;
+            case '/math.Math/Sum':
+                $call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => []]);
+                do {
+                    $event = $call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+                } while ($event->message !== null);
+                $call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $response],
+                    Grpc\OP_SEND_STATUS_FROM_SERVER => $ok,
+                    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+                ]);
+                break;
+            case '/math.Math/Fib':
+                $call->startBatch([
+                    Grpc\OP_SEND_INITIAL_METADATA => [],
+                    Grpc\OP_RECV_MESSAGE => true,
+                ]);
+                for ($i = 0; $i < $stream_length; ++$i) {
+                    $call->startBatch([
+                        Grpc\OP_SEND_MESSAGE => ['message' => $response],
+                    ]);
+                }
+                $call->startBatch([
+                    Grpc\OP_SEND_STATUS_FROM_SERVER => $ok,
+                    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+                ]);
+                break;
+            case '/math.Math/DivMany':
+                $call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => []]);
+                while (($event = $call->startBatch([
+                    Grpc\OP_RECV_MESSAGE => true,
+                ]))->message !== null) {
+                    $call->startBatch([
+                        Grpc\OP_SEND_MESSAGE => ['message' => $event->message],
+                    ]);
+                }
+                $call->startBatch([
+                    Grpc\OP_SEND_STATUS_FROM_SERVER => $ok,
+                    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+                ]);
+                break;
+            default:
+                $call->startBatch([
+                    Grpc\OP_SEND_INITIAL_METADATA => [],
+                    Grpc\OP_SEND_STATUS_FROM_SERVER => [
+                        'metadata' => [],
+                        'code' => Grpc\STATUS_UNIMPLEMENTED,
+                        'details' => '',
+                    ],
+                    Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+                ]);
+        }
+    }
+}
+
+/**
+ * Make one unary call with the API given by --unary_api and return its
+ * status.
+ */
+function runUnary($stub, $channel, $unary_api, $method, $request)
+{
+    $deserialize = ['QpsPayload', 'decode'];
+    switch ($unary_api) {
+        case 'blocking':
+            list($response, $status) = $stub->_simpleRequest(
+                $method, $request, $deserialize, [],
+                ['blocking' => true])->wait();
+            break;
+        case 'two_batches':
+            $call = new Grpc\Call($channel, $method,
+                                   Grpc\Timeval::infFuture());
+            $call->startBatch([
+                Grpc\OP_SEND_INITIAL_METADATA => [],
+                Grpc\OP_RECV_INITIAL_METADATA => true,
+                Grpc\OP_SEND_MESSAGE => ['message' => $request->serialize()],
+                Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+            ]);
+            $event = $call->startBatch([
+                Grpc\OP_RECV_MESSAGE => true,
+                Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+            ]);
+            QpsPayload::decode($event->message);
+            $status = $event->status;
+            break;
+        default:
+            list($response, $status) = $stub->_simpleRequest(
+                $method, $request, $deserialize)->wait();
+    }
+
+    return $status;
+}
+
+/**
+ * Make one call of a workload and throw if it fails.
+ */
+function runCall($stub, $channel, $args, $method, $request)
+{
+    $deserialize = ['QpsPayload', 'decode'];
+    $stream_length = (int) $args['stream_length'];
+    switch ($args['workload']) {
+        case 'unary':
+            $status = runUnary($stub, $channel, $args['unary_api'], $method,
+                               $request);
+            break;
+        case 'client_streaming':
+            $call = $stub->_clientStreamRequest($method, $deserialize);
+            for ($i = 0; $i < $stream_length; ++$i) {
+                $call->write($request);
+            }
+            list($response, $status) = $call->wait();
+            break;
+        case 'server_streaming':
+            $call = $stub->_serverStreamRequest($method, $request,
+                                                $deserialize);
+            foreach ($call->responses() as $response) {
+            }
+            $status = $call->getStatus();
+            break;
+        case 'bidi':
+            $call = $stub->_bidiRequest($method, $deserialize);
+            for ($i = 0; $i < $stream_length; ++$i) {
+                $call->write($request);
+                $call->read();
+            }
+            $call->writesDone();
+            $status = $call->getStatus();
+            break;
+    }
+    if ($status->code !== Grpc\STATUS_OK) {
+        throw new RuntimeException("$method failed: $status->details");
+    }
+}
+
+/**
+ * Make calls for the warmup and the duration, then print the latencies of
+ * the calls made during the duration and the CPU time they took.
+ */
+function runClient($args, $methods)
+{
+    $stub = new Grpc\BaseStub($args['target'], [
+        'credentials' => Grpc\ChannelCredentials::createInsecure(),
+    ]);
+    if (!$stub->waitForReady(5000000)) {
+        fwrite(STDERR, "Cannot connect to {$args['target']}\n");
+        exit(1);
+    }
+    $channel = new Grpc\Channel($args['target'], [
+        'credentials' => Grpc\ChannelCredentials::createInsecure(),
+    ]);
+    $method = $methods[$args['workload']];
+    $request = new QpsPayload(str_repeat('x', (int) $args['payload']));
+
+    $start = microtime(true);
+    $measure_from = $start + $args['warmup'];
+    $end = $measure_from + $args['duration'];
+    while (microtime(true) < $measure_from) {
+        runCall($stub, $channel, $args, $method, $request);
+    }
+    $cpu_start = cpuTime();
+    $latencies = [];
+    while (($call_start = microtime(true)) < $end) {
+        runCall($stub, $channel, $args, $method, $request);
+        $latencies[] = (microtime(true) - $call_start) * 1e6;
+    }
+    echo json_encode([
+        'cpu_us' => cpuTime() - $cpu_start,
+        'latencies' => base64_encode(pack('d*', ...$latencies)),
+    ]), "\n";
+}
+
+/**
+ * Returns the latency under which a fraction of the sorted latencies are.
+ */
+function percentile($sorted, $fraction)
+{
+    if (count($sorted) === 0) {
+        return;
+    }
+
+    return $sorted[min(count($sorted) - 1,
+                       (int) floor(count($sorted) * $fraction))];
+}
+
+/**
+ * Start the servers and the clients, and report their results.
+ */
+function runDriver($args, $methods)
+{
+    $workload = $args['workload'];
+    if (!isset($methods[$workload])) {
+        fwrite(STDERR, "Unknown workload $workload, expected one of ".
+               implode(', ', array_keys($methods))."\n");
+        exit(1);
+    }
+    $concurrency = (int) $args['concurrency'];
+    $servers = [];
+    $targets = [];
+    if (isset($args['target'])) {
+        $targets[] = $args['target'];
+    } else {
+        for ($i = 0; $i < (int) $args['server_workers']; ++$i) {
+            $server_args = $args;
+            $server_args['socket'] = sys_get_temp_dir().
+                '/grpc_qps_'.getmypid()."_$i.sock";
+            $process = proc_open(childCommand('server', $server_args),
+                                 [1 => ['pipe', 'w']], $pipes);
+            $address = trim(fgets($pipes[1]));
+            if ($address === '') {
+                fwrite(STDERR, "A server failed to start\n");
+                exit(1);
+            }
+            $servers[] = [$process, $pipes, $server_args['socket']];
+            $targets[] = $address;
+        }
+    }
+
+    $clients = [];
+    for ($i = 0; $i < $concurrency; ++$i) {
+        $client_args = $args;
+        $client_args['target'] = $targets[$i % count($targets)];
+        $process = proc_open(childCommand('client', $client_args),
+                             [1 => ['pipe', 'w']], $pipes);
+        $clients[] = [$process, $pipes];
+    }
+
+    // Sample the servers over the same window as the clients
+    usleep((int) ($args['warmup'] * 1e6));
+    $server_cpu_start = 0;
+    foreach ($servers as $server) {
+        $server_cpu_start += processCpuTime(
+            proc_get_status($server[0])['pid']);
+    }
+
+    $latencies = [];
+    $client_cpu = 0;
+    foreach ($clients as $client) {
+        $result = json_decode(stream_get_contents($client[1][1]), true);
+        proc_close($client[0]);
+        if ($result === null) {
+            fwrite(STDERR, "A client failed\n");
+            exit(1);
+        }
+        $client_cpu += $result['cpu_us'];
+        $latencies = array_merge($latencies, array_values(
+            unpack('d*', base64_decode($result['latencies']))));
+    }
+
+    $server_cpu = null;
+    if (count($servers) > 0) {
+        $server_cpu = -$server_cpu_start;
+        foreach ($servers as $server) {
+            $server_cpu += processCpuTime(
+                proc_get_status($server[0])['pid']);
+            proc_terminate($server[0]);
+            proc_close($server[0]);
+            @unlink($server[2]);
+        }
+    }
+
+    sort($latencies);
+    $rpcs = count($latencies);
+    echo json_encode([
+        'workload' => $workload,
+        'unary_api' => $args['unary_api'],
+        'transport' => isset($args['target']) ? $args['target']
+                                              : $args['transport'],
+        'concurrency' => $concurrency,
+        'server_workers' => count($servers),
+        'payload' => (int) $args['payload'],
+        'stream_length' => (int) $args['stream_length'],
+        'duration' => (float) $args['duration'],
+        'rpcs' => $rpcs,
+        'qps' => $rpcs / $args['duration'],
+        'latency_us' => [
+            'p50' => percentile($latencies, 0.5),
+            'p99' => percentile($latencies, 0.99),
+            'p999' => percentile($latencies, 0.999),
+            'max' => $rpcs > 0 ? $latencies[$rpcs - 1] : null,
+        ],
+        'cpu_us_per_rpc' => [
+            'client' => $rpcs > 0 ? $client_cpu / $rpcs : null,
+            'server' => $rpcs > 0 && $server_cpu !== null
+                ? $server_cpu / $rpcs : null,
+        ],
+    ], JSON_PRETTY_PRINT), "\n";
+}
+
+$args = getopt('', ['role:', 'workload:', 'concurrency:', 'server_workers:',
+                    'payload:', 'stream_length:', 'duration:', 'warmup:',
+                    'transport:', 'target:', 'socket:', 'unary_api:']);
+$args += [
+    'role' => 'driver',
+    'workload' => 'unary',
+    'concurrency' => 4,
+    'payload' => 0,
+    'stream_length' => 10,
+    'duration' => 10,
+    'warmup' => 2,
+    'transport' => 'tcp',
+    'unary_api' => 'async',
+];
+// One server per client by default, as a PHP server handles one call at a
+// time
+$args += ['server_workers' => $args['concurrency']];
+
+switch ($args['role']) {
+    case 'server':
+        runServer($args);
+        break;
+    case 'client':
+        runClient($args, $methods);
+        break;
+    default:
+        runDriver($args, $methods);
+}
@@ -0,0 +1,245 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+/*
+ * Soak test of the extension for long-running workers. It makes calls of
+ * every shape between a client and a server in this process, samples the
+ * memory of the process as it goes, and fails if the memory grows by more
+ * than the thresholds per 100k calls once warmed up:
+ *   bin/run_soak_test.sh [--calls=1000000] [--warmup=100000]
+ *       [--sample_every=10000] [--payload=1024]
+ *       [--max_php_growth=65536] [--max_rss_growth=1048576]
+ * Samples and the verdict are printed as JSON, and the exit status is 1 on
+ * failure.
+ */
+
+$args = getopt('', ['calls:', 'warmup:', 'sample_every:', 'payload:',
+                    'max_php_growth:', 'max_rss_growth:']);
+$args += [
+    'calls' => 1000000,
+    'warmup' => 100000,
+    'sample_every' => 10000,
+    'payload' => 1024,
+    // Bytes per 100k calls
+    'max_php_growth' => 64 * 1024,
+    'max_rss_growth' => 1024 * 1024,
+];
+
+/**
+ * The resident set size of the process in bytes, or null where /proc is not
+ * available.
+ */
+function rss()
+{
+    $status = @file_get_contents('/proc/self/status');
+    if ($status === false ||
+        !preg_match('/^VmRSS:\s+(\d+) kB/m', $status, $matches)) {
+        return;
+    }
+
+    return $matches[1] * 1024;
+}
+
+/**
+ * Sends the status of a server call and waits for the client to close.
+ */
+function finishServerCall($server_call, $metadata)
+{
+    $server_call->startBatch([
+        Grpc\OP_SEND_STATUS_FROM_SERVER => [
+            'metadata' => $metadata,
+            'code' => Grpc\STATUS_OK,
+            'details' => 'done',
+        ],
+        Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+    ]);
+}
+
+/**
+ * Makes one call of the given shape between the channel and the server,
+ * and throws if it does not complete as expected.
+ */
+function soakCall($channel, $server, $shape, $payload, $metadata)
+{
+    $messages = 3;
+    $call = new Grpc\Call($channel, "/soak/$shape",
+                          Grpc\Timeval::infFuture());
+    $call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => $metadata]);
+    $server_call = $server->requestCall()->call;
+    $server_call->startBatch([Grpc\OP_SEND_INITIAL_METADATA => $metadata]);
+    $call->startBatch([Grpc\OP_RECV_INITIAL_METADATA => true]);
+
+    $received = 0;
+    switch ($shape) {
+        case 'unary':
+            $call->startBatch([
+                Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+                Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+            ]);
+            $server_call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+            $server_call->startBatch([
+                Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+            ]);
+            $received += $call->startBatch([
+                Grpc\OP_RECV_MESSAGE => true,
+            ])->message === $payload;
+            break;
+        case 'client_streaming':
+            for ($i = 0; $i < $messages; ++$i) {
+                $call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+                ]);
+                $server_call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+            }
+            $call->startBatch([Grpc\OP_SEND_CLOSE_FROM_CLIENT => true]);
+            $server_call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+            $server_call->startBatch([
+                Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+            ]);
+            $received += $call->startBatch([
+                Grpc\OP_RECV_MESSAGE => true,
+            ])->message === $payload;
+            break;
+        case 'server_streaming':
+            $call->startBatch([
+                Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+                Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+            ]);
+            $server_call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+            for ($i = 0; $i < $messages; ++$i) {
+                $server_call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+                ]);
+                $received += $call->startBatch([
+                    Grpc\OP_RECV_MESSAGE => true,
+                ])->message === $payload;
+            }
+            break;
+        case 'bidi':
+            for ($i = 0; $i < $messages; ++$i) {
+                $call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $payload],
+                ]);
+                $message = $server_call->startBatch([
+                    Grpc\OP_RECV_MESSAGE => true,
+                ])->message;
+                $server_call->startBatch([
+                    Grpc\OP_SEND_MESSAGE => ['message' => $message],
+                ]);
+                $received += $call->startBatch([
+                    Grpc\OP_RECV_MESSAGE => true,
+                ])->message === $payload;
+            }
+            $call->startBatch([Grpc\OP_SEND_CLOSE_FROM_CLIENT => true]);
+            $server_call->startBatch([Grpc\OP_RECV_MESSAGE => true]);
+            break;
+    }
+
+    finishServerCall($server_call, $metadata);
+    $status = $call->startBatch([
+        Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+    ])->status;
+    $call->getPeer();
+    $server_call->getPeer();
+    $expected = $shape === 'unary' || $shape === 'client_streaming'
+        ? 1 : $messages;
+    if ($status->code !== Grpc\STATUS_OK || $received !== $expected ||
+        $status->metadata !== $metadata) {
+        throw new RuntimeException("The $shape call did not complete");
+    }
+}
+
+$server = new Grpc\Server([]);
+$port = $server->addHttp2Port('127.0.0.1:0');
+$server->start();
+$channel = new Grpc\Channel('127.0.0.1:'.$port, [
+    'credentials' => Grpc\ChannelCredentials::createInsecure(),
+]);
+$shapes = ['unary', 'client_streaming', 'server_streaming', 'bidi'];
+$payload = str_repeat('x', (int) $args['payload']);
+$metadata = [
+    'x-soak-key' => ['value'],
+    'x-soak-bin' => ["\x00\x01\x02"],
+];
+
+$samples = [];
+$baseline = null;
+for ($calls = 0; $calls <= $args['calls']; ++$calls) {
+    if ($calls % $args['sample_every'] === 0) {
+        $channel->getTarget();
+        $sample = [
+            'calls' => $calls,
+            'php' => memory_get_usage(),
+            'php_peak' => memory_get_peak_usage(),
+            'rss' => rss(),
+        ];
+        $samples[] = $sample;
+        if ($calls >= $args['warmup'] && $baseline === null) {
+            $baseline = $sample;
+        }
+    }
+    if ($calls < $args['calls']) {
+        soakCall($channel, $server, $shapes[$calls % count($shapes)],
+                 $payload, $metadata);
+    }
+}
+
+$last = end($samples);
+$growth = null;
+$failures = [];
+if ($baseline !== null && $last['calls'] > $baseline['calls']) {
+    $per_100k = 100000 / ($last['calls'] - $baseline['calls']);
+    $growth = [
+        'php' => ($last['php'] - $baseline['php']) * $per_100k,
+        'php_peak' => ($last['php_peak'] - $baseline['php_peak']) * $per_100k,
+        'rss' => $last['rss'] === null ? null
+            : ($last['rss'] - $baseline['rss']) * $per_100k,
+    ];
+    if (max($growth['php'], $growth['php_peak']) > $args['max_php_growth']) {
+        $failures[] = 'PHP memory grew by '.
+            (int) max($growth['php'], $growth['php_peak']).
+            ' bytes per 100k calls';
+    }
+    if ($growth['rss'] !== null && $growth['rss'] > $args['max_rss_growth']) {
+        $failures[] = 'RSS grew by '.(int) $growth['rss'].
+            ' bytes per 100k calls';
+    }
+}
+
+echo json_encode([
+    'growth_per_100k_calls' => $growth,
+    'failures' => $failures,
+    'samples' => $samples,
+], JSON_PRETTY_PRINT), "\n";
+exit(count($failures) > 0 ? 1 : 0);
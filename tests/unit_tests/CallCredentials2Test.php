@@ -132,4 +132,89 @@ class CallCredentials2Test extends PHPUnit_Framework_TestCase
         unset($call);
         unset($server_call);
     }
+
+    public function cachedCallbackFunc($context)
+    {
+        ++$this->cached_callback_count;
+
+        return ['k1' => ['v1']];
+    }
+
+    private function doCachedCall($call_credentials)
+    {
+        $call = new Grpc\Call($this->channel,
+                              '/abc/dummy_method',
+                              Grpc\Timeval::infFuture(),
+                              $this->host_override);
+        $call->setCredentials($call_credentials);
+        $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+        ]);
+
+        $event = $this->server->requestCall();
+        $this->assertSame(['v1'], $event->metadata['k1']);
+        $server_call = $event->call;
+        $server_call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_STATUS_FROM_SERVER => [
+                'metadata' => [],
+                'code' => Grpc\STATUS_OK,
+                'details' => '',
+            ],
+            Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+        ]);
+        $event = $call->startBatch([
+            Grpc\OP_RECV_INITIAL_METADATA => true,
+            Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+        ]);
+        $this->assertSame(Grpc\STATUS_OK, $event->status->code);
+    }
+
+    public function testCreateFromPluginWithCache()
+    {
+        $this->cached_callback_count = 0;
+        $call_credentials = Grpc\CallCredentials::createFromPlugin(
+            array($this, 'cachedCallbackFunc'),
+            ['cache_ttl' => 3600, 'cache_key' => uniqid('test', true)]);
+
+        $this->doCachedCall($call_credentials);
+        $this->doCachedCall($call_credentials);
+        $this->assertSame(1, $this->cached_callback_count);
+    }
+
+    public function testCreateFromPluginWithCacheWithoutKey()
+    {
+        // Without a cache key, plugins do not share their cached metadata
+        $this->cached_callback_count = 0;
+        $first = Grpc\CallCredentials::createFromPlugin(
+            array($this, 'cachedCallbackFunc'), ['cache_ttl' => 3600]);
+        $second = Grpc\CallCredentials::createFromPlugin(
+            array($this, 'cachedCallbackFunc'), ['cache_ttl' => 3600]);
+
+        $this->doCachedCall($first);
+        $this->doCachedCall($first);
+        $this->doCachedCall($second);
+        $this->assertSame(2, $this->cached_callback_count);
+    }
+
+    public function testCreateFromPluginWithCacheWhenFull()
+    {
+        // Fill the cache, which keeps 1024 pairs, with unexpired entries
+        $this->cached_callback_count = 0;
+        for ($i = 0; $i < 1025; ++$i) {
+            $this->doCachedCall(Grpc\CallCredentials::createFromPlugin(
+                array($this, 'cachedCallbackFunc'),
+                ['cache_ttl' => 3600, 'cache_key' => uniqid('fill', true)]));
+        }
+
+        // A new pair still gets cached in place of an older one
+        $this->cached_callback_count = 0;
+        $call_credentials = Grpc\CallCredentials::createFromPlugin(
+            array($this, 'cachedCallbackFunc'),
+            ['cache_ttl' => 3600, 'cache_key' => uniqid('test', true)]);
+        $this->doCachedCall($call_credentials);
+        $this->doCachedCall($call_credentials);
+        $this->assertSame(1, $this->cached_callback_count);
+    }
 }
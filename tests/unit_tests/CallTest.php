@@ -31,6 +31,18 @@
  * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  *
  */
+class SubclassedChannel extends Grpc\Channel
+{
+}
+
+class SubclassedChannelPool extends Grpc\ChannelPool
+{
+}
+
+class SubclassedTimeval extends Grpc\Timeval
+{
+}
+
 class CallTest extends PHPUnit_Framework_TestCase
 {
     public static $server;
@@ -113,6 +125,60 @@ class CallTest extends PHPUnit_Framework_TestCase
       $this->assertNull($this->call->cancel());
     }
 
+    public function testConstructWithTimeoutMicros()
+    {
+        $call = new Grpc\Call($this->channel, '/foo', 1000000);
+        $this->assertSame('Grpc\Call', get_class($call));
+    }
+
+    public function testConstructWithChannelSubclass()
+    {
+        $channel = new SubclassedChannel('localhost:'.self::$port, []);
+        $call = new Grpc\Call($channel, '/foo', null);
+        $this->assertSame('Grpc\Call', get_class($call));
+
+        $pool = new SubclassedChannelPool('localhost:'.self::$port, [], 2);
+        $call = new Grpc\Call($pool, '/foo', null);
+        $this->assertSame('Grpc\Call', get_class($call));
+    }
+
+    public function testConstructWithoutDeadline()
+    {
+        $call = new Grpc\Call($this->channel, '/foo', null);
+        $this->assertSame('Grpc\Call', get_class($call));
+    }
+
+    public function testConstructWithTimevalSubclassDeadline()
+    {
+        $deadline = new SubclassedTimeval(1000000);
+        $call = new Grpc\Call($this->channel, '/foo', $deadline);
+        $this->assertSame('Grpc\Call', get_class($call));
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testInvalidDeadline()
+    {
+        $call = new Grpc\Call($this->channel, '/foo', 'abc');
+    }
+
+    /**
+     * @expectedException LogicException
+     */
+    public function testFinishBatchWithoutAsyncBatch()
+    {
+        $this->call->finishBatch();
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testSetInvalidDeserializer()
+    {
+        $this->call->setDeserializer('not a callable or class');
+    }
+
     /**
      * @expectedException InvalidArgumentException
      */
@@ -60,6 +60,26 @@ class ChanellCredentialsTest extends PHPUnit_Framework_TestCase
         $this->assertSame('Grpc\ChannelCredentials', get_class($channel_credentials));
     }
 
+    public function testCreateSslTwice()
+    {
+        $pem = file_get_contents(dirname(__FILE__).'/../data/ca.pem');
+        $channel_credentials = Grpc\ChannelCredentials::createSsl($pem);
+        $channel_credentials2 = Grpc\ChannelCredentials::createSsl($pem);
+        $this->assertSame('Grpc\ChannelCredentials',
+                          get_class($channel_credentials2));
+        unset($channel_credentials);
+        $channel = new Grpc\Channel('localhost:0',
+                                    ['credentials' => $channel_credentials2]);
+        $this->assertSame('Grpc\Channel', get_class($channel));
+    }
+
+    public function testDefaultRootsPemSet()
+    {
+        Grpc\ChannelCredentials::setDefaultRootsPem(
+            file_get_contents(dirname(__FILE__).'/../data/ca.pem'));
+        $this->assertTrue(Grpc\ChannelCredentials::isDefaultRootsPemSet());
+    }
+
     /**
      * @expectedException ErrorException
      */
@@ -0,0 +1,95 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+class ChannelPoolTest extends PHPUnit_Framework_TestCase
+{
+    public function setUp()
+    {
+        $this->server = new Grpc\Server([]);
+        $this->port = $this->server->addHttp2Port('0.0.0.0:0');
+        $this->server->start();
+        $this->pool = new Grpc\ChannelPool('localhost:'.$this->port, [], 3);
+    }
+
+    public function tearDown()
+    {
+        unset($this->pool);
+        unset($this->server);
+    }
+
+    public function testGetChannels()
+    {
+        $this->assertSame(3, $this->pool->getSize());
+        $channels = $this->pool->getChannels();
+        $this->assertCount(3, $channels);
+        foreach ($channels as $channel) {
+            $this->assertSame('Grpc\Channel', get_class($channel));
+        }
+        $this->assertTrue(is_string($this->pool->getTarget()));
+    }
+
+    public function testCallsSpreadOverChannels()
+    {
+        $deadline = Grpc\Timeval::infFuture();
+        $calls = [];
+        $channels = [];
+        for ($i = 0; $i < 3; ++$i) {
+            $calls[] = $call = new Grpc\Call($this->pool,
+                                             'dummy_method',
+                                             $deadline);
+            $channels[spl_object_hash($call->channel)] = true;
+        }
+        $this->assertCount(3, $channels);
+        $this->assertSame(3, $this->pool->getInFlight());
+        unset($calls);
+        $this->assertSame(0, $this->pool->getInFlight());
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testInvalidSize()
+    {
+        new Grpc\ChannelPool('localhost:0', [], 0);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testClosedPool()
+    {
+        $this->pool->close();
+        new Grpc\Call($this->pool, 'dummy_method', Grpc\Timeval::infFuture());
+    }
+}
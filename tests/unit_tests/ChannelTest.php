@@ -90,4 +90,36 @@ class ChannelTest extends PHPUnit_Framework_TestCase
             ]
         );
     }
+
+    public function testWaitForReadyTimeout()
+    {
+        $this->channel = new Grpc\Channel(
+            'localhost:0',
+            [
+                'credentials' => Grpc\ChannelCredentials::createInsecure(),
+            ]
+        );
+        $this->assertFalse($this->channel->waitForReady(1000));
+    }
+
+    public function testWaitAllReadyTimeout()
+    {
+        $opts = [
+            'credentials' => Grpc\ChannelCredentials::createInsecure(),
+        ];
+        $channels = [
+            new Grpc\Channel('localhost:0', $opts),
+            new Grpc\ChannelPool('localhost:0', $opts, 2),
+        ];
+        $this->assertFalse(Grpc\Channel::waitAllReady($channels, 1000));
+        $this->assertTrue(Grpc\Channel::waitAllReady([], 1000));
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testWaitAllReadyInvalidChannel()
+    {
+        Grpc\Channel::waitAllReady([new Grpc\Timeval(100)], 1000);
+    }
 }
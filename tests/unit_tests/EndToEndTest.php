@@ -107,6 +107,420 @@ class EndToEndTest extends PHPUnit_Framework_TestCase
         unset($server_call);
     }
 
+    public function testTimeoutMicrosDeadlineExceeded()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              100000);
+
+        $event = $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+        ]);
+
+        $this->assertTrue($event->send_metadata);
+        $this->assertTrue($event->send_close);
+
+        // The server never answers
+        $event = $call->startBatch([
+            Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+        ]);
+
+        $this->assertSame(Grpc\STATUS_DEADLINE_EXCEEDED,
+                          $event->status->code);
+
+        unset($call);
+    }
+
+    public function testUnaryDeadlineExceeded()
+    {
+        // The server never answers, so the call runs until its deadline
+        list($response, $status, $metadata) = Grpc\Call::unary(
+            $this->channel, 'dummy_method', 'request', ['key' => ['value']],
+            100000);
+
+        $this->assertNull($response);
+        $this->assertSame(Grpc\STATUS_DEADLINE_EXCEEDED, $status->code);
+        $this->assertTrue(is_string($status->details));
+        $this->assertSame([], $metadata);
+
+        $event = $this->server->requestCall();
+        $this->assertSame('dummy_method', $event->method);
+        $this->assertSame(['value'], $event->metadata['key']);
+    }
+
+    public function testChannelStats()
+    {
+        $stats = $this->channel->getStats();
+        $this->assertSame(0, $stats['calls_started']);
+        $this->assertSame(0, $stats['latency_us']['count']);
+
+        list($response, $status, $metadata) = Grpc\Call::unary(
+            $this->channel, 'dummy_method', 'request', [], 100000);
+
+        $stats = $this->channel->getStats();
+        $this->assertSame(1, $stats['calls_started']);
+        $this->assertSame(0, $stats['calls_succeeded']);
+        $this->assertSame(1, $stats['calls_failed']);
+        $this->assertSame(0, $stats['calls_in_flight']);
+        $this->assertSame([Grpc\STATUS_DEADLINE_EXCEEDED => 1],
+                          $stats['status_codes']);
+        $this->assertSame(strlen('request'), $stats['bytes_sent']);
+        $this->assertSame(0, $stats['bytes_received']);
+        $this->assertSame(1, $stats['latency_us']['count']);
+        $this->assertGreaterThanOrEqual(100000, $stats['latency_us']['max']);
+        $this->assertLessThanOrEqual($stats['latency_us']['max'],
+                                     $stats['latency_us']['p50']);
+    }
+
+    public function testCallTimings()
+    {
+        // Only send ops are used, as the server never accepts the call
+        $deadline = Grpc\Timeval::infFuture();
+        $call = new Grpc\Call($this->channel, 'dummy_method', $deadline);
+
+        $event = $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+        ]);
+        $this->assertFalse(isset($event->timings));
+        $this->assertSame(0, $call->getTimings()['batches']);
+
+        $call->enableTimings();
+        $event = $call->startBatch([
+            Grpc\OP_SEND_MESSAGE => ['message' => 'request'],
+        ]);
+        $this->assertSame(['build_ns', 'wait_ns', 'convert_ns'],
+                          array_keys($event->timings));
+        $this->assertGreaterThan(0, $event->timings['wait_ns']);
+
+        $timings = $call->getTimings();
+        $this->assertSame(1, $timings['batches']);
+        $this->assertSame($event->timings['wait_ns'], $timings['wait_ns']);
+
+        $call->enableTimings(false);
+        $event = $call->startBatch([
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+        ]);
+        $this->assertFalse(isset($event->timings));
+        $this->assertSame(1, $call->getTimings()['batches']);
+    }
+
+    public function testSlowCallLog()
+    {
+        $log = tempnam(sys_get_temp_dir(), 'grpc_slow_calls');
+        ini_set('grpc.slow_call_log', $log);
+        ini_set('grpc.slow_call_threshold_ms', 50);
+        try {
+            Grpc\Call::unary($this->channel, 'fast_method', 'request', [],
+                             1000);
+            Grpc\Call::unary($this->channel, 'slow_method', 'request', [],
+                             100000);
+            Grpc\Call::flushSlowCallLog();
+            $lines = file($log);
+        } finally {
+            ini_restore('grpc.slow_call_threshold_ms');
+            ini_restore('grpc.slow_call_log');
+            unlink($log);
+        }
+
+        $this->assertCount(1, $lines);
+        $call = json_decode($lines[0], true);
+        $this->assertSame('slow_method', $call['method']);
+        $this->assertSame('localhost:'.$this->port, $call['target']);
+        $this->assertSame(Grpc\STATUS_DEADLINE_EXCEEDED, $call['status']);
+        $this->assertGreaterThanOrEqual(100, $call['duration_ms']);
+        $this->assertSame(strlen('request'), $call['bytes_sent']);
+        $this->assertSame(0, $call['bytes_received']);
+        $this->assertLessThanOrEqual(0, $call['deadline_remaining_ms']);
+    }
+
+    public function testSlowCallLogAfterChannelClose()
+    {
+        $log = tempnam(sys_get_temp_dir(), 'grpc_slow_calls');
+        ini_set('grpc.slow_call_log', $log);
+        ini_set('grpc.slow_call_threshold_ms', 50);
+        try {
+            $call = new Grpc\Call($this->channel, 'slow_method', 100000);
+            // The call outlives the channel it was created on
+            $this->channel->close();
+            $call->startBatch([
+                Grpc\OP_SEND_INITIAL_METADATA => [],
+                Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+                Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+            ]);
+            Grpc\Call::flushSlowCallLog();
+            $lines = file($log);
+        } finally {
+            ini_restore('grpc.slow_call_threshold_ms');
+            ini_restore('grpc.slow_call_log');
+            unlink($log);
+        }
+
+        $this->assertCount(1, $lines);
+        $call = json_decode($lines[0], true);
+        $this->assertSame('localhost:'.$this->port, $call['target']);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testUnaryInvalidMetadata()
+    {
+        Grpc\Call::unary($this->channel, 'dummy_method', 'request',
+                         ['key' => 'value']);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testUnaryClosedChannel()
+    {
+        $this->channel->close();
+        Grpc\Call::unary($this->channel, 'dummy_method', 'request');
+    }
+
+    public function testStartBatchAsync()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+        // The whole call is sent before the server is asked for it
+        $call->startBatchAsync([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_RECV_INITIAL_METADATA => true,
+            Grpc\OP_SEND_MESSAGE => ['message' => 'request'],
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+            Grpc\OP_RECV_MESSAGE => true,
+            Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+        ]);
+
+        $server_call = $this->server->requestCall()->call;
+        $event = $server_call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => ['key' => ['value']],
+            Grpc\OP_RECV_MESSAGE => true,
+            Grpc\OP_SEND_MESSAGE => ['message' => 'response'],
+            Grpc\OP_SEND_STATUS_FROM_SERVER => [
+                'metadata' => [],
+                'code' => Grpc\STATUS_OK,
+                'details' => '',
+            ],
+            Grpc\OP_RECV_CLOSE_ON_SERVER => true,
+        ]);
+        $this->assertSame('request', $event->message);
+
+        $event = $call->finishBatch();
+        $this->assertTrue($event->send_message);
+        $this->assertSame(['value'], $event->metadata['key']);
+        $this->assertSame('response', $event->message);
+        $this->assertSame(Grpc\STATUS_OK, $event->status->code);
+    }
+
+    /**
+     * @expectedException LogicException
+     */
+    public function testStartBatchWhileAsyncBatchPending()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+        $call->startBatchAsync([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+        ]);
+        $call->startBatch([
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+        ]);
+    }
+
+    public function testBatchTemplate()
+    {
+        $req_text = 'message_write_flags_test';
+        $status_text = 'xyz';
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+
+        $send = new Grpc\BatchTemplate([
+            Grpc\OP_SEND_INITIAL_METADATA,
+            Grpc\OP_SEND_MESSAGE,
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT,
+        ], Grpc\WRITE_NO_COMPRESS);
+        $event = $send->execute($call, [], $req_text);
+
+        $this->assertTrue($event->send_metadata);
+        $this->assertTrue($event->send_message);
+        $this->assertTrue($event->send_close);
+
+        $event = $this->server->requestCall();
+        $this->assertSame('dummy_method', $event->method);
+        $server_call = $event->call;
+
+        $reply = new Grpc\BatchTemplate([
+            Grpc\OP_SEND_INITIAL_METADATA,
+            Grpc\OP_RECV_MESSAGE,
+            Grpc\OP_SEND_STATUS_FROM_SERVER,
+            Grpc\OP_RECV_CLOSE_ON_SERVER,
+        ]);
+        $event = $reply->execute($server_call, [], Grpc\STATUS_OK,
+                                 $status_text, []);
+
+        $this->assertTrue($event->send_metadata);
+        $this->assertSame($req_text, $event->message);
+        $this->assertTrue($event->send_status);
+        $this->assertFalse($event->cancelled);
+
+        $recv = new Grpc\BatchTemplate([
+            Grpc\OP_RECV_INITIAL_METADATA,
+            Grpc\OP_RECV_STATUS_ON_CLIENT,
+        ]);
+        $event = $recv->execute($call);
+
+        $status = $event->status;
+        $this->assertSame([], $status->metadata);
+        $this->assertSame(Grpc\STATUS_OK, $status->code);
+        $this->assertSame($status_text, $status->details);
+
+        unset($call);
+        unset($server_call);
+    }
+
+    public function testParentCallDeadline()
+    {
+        $parent_call = new Grpc\Call($this->channel,
+                                     'parent_method',
+                                     100000);
+        $parent_call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+        ]);
+        $server_call = $this->server->requestCall()->call;
+
+        // The child call has no deadline of its own
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              null,
+                              null,
+                              $server_call);
+        $event = $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_CLOSE_FROM_CLIENT => true,
+            Grpc\OP_RECV_STATUS_ON_CLIENT => true,
+        ]);
+        $this->assertSame(Grpc\STATUS_DEADLINE_EXCEEDED,
+                          $event->status->code);
+
+        unset($call);
+        unset($server_call);
+        unset($parent_call);
+    }
+
+    public function testServerContext()
+    {
+        $parent_call = new Grpc\Call($this->channel,
+                                     'parent_method',
+                                     100000);
+        $parent_call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+        ]);
+        $server_call = $this->server->requestCall()->call;
+        Grpc\Call::setServerContext($server_call);
+        $this->assertSame($server_call, Grpc\Call::getServerContext());
+
+        list($response, $status, $metadata) = Grpc\Call::unary(
+            $this->channel, 'dummy_method', 'request');
+        $this->assertSame(Grpc\STATUS_DEADLINE_EXCEEDED, $status->code);
+
+        Grpc\Call::setServerContext(null);
+        $this->assertNull(Grpc\Call::getServerContext());
+        unset($server_call);
+        unset($parent_call);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testClientCallAsParent()
+    {
+        $parent_call = new Grpc\Call($this->channel,
+                                     'parent_method',
+                                     Grpc\Timeval::infFuture());
+        new Grpc\Call($this->channel, 'dummy_method', null, null,
+                       $parent_call);
+    }
+
+    public function testDeserializer()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+        $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_MESSAGE => ['message' => 'abc'],
+        ]);
+
+        $server_call = $this->server->requestCall()->call;
+        $server_call->setDeserializer('strrev');
+        $event = $server_call->startBatch([
+            Grpc\OP_RECV_MESSAGE => true,
+        ]);
+        $this->assertSame('cba', $event->message);
+
+        unset($call);
+        unset($server_call);
+    }
+
+    public function testDeserializeIntoInstance()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+        $call->startBatch([
+            Grpc\OP_SEND_INITIAL_METADATA => [],
+            Grpc\OP_SEND_MESSAGE => ['message' => 'abc'],
+        ]);
+
+        $server_call = $this->server->requestCall()->call;
+        $instance = new ArrayObject();
+        $server_call->setDeserializer('append', $instance);
+        $event = $server_call->startBatch([
+            Grpc\OP_RECV_MESSAGE => true,
+        ]);
+        $this->assertSame($instance, $event->message);
+        $this->assertSame(['abc'], $instance->getArrayCopy());
+
+        unset($call);
+        unset($server_call);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testBatchTemplateInvalidOp()
+    {
+        new Grpc\BatchTemplate([Grpc\OP_SEND_MESSAGE, 42]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testBatchTemplateDuplicateOp()
+    {
+        new Grpc\BatchTemplate([Grpc\OP_RECV_MESSAGE, Grpc\OP_RECV_MESSAGE]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testBatchTemplateWrongValueCount()
+    {
+        $call = new Grpc\Call($this->channel,
+                              'dummy_method',
+                              Grpc\Timeval::infFuture());
+        $send = new Grpc\BatchTemplate([
+            Grpc\OP_SEND_INITIAL_METADATA,
+            Grpc\OP_SEND_MESSAGE,
+        ]);
+        $send->execute($call, []);
+    }
+
     public function testMessageWriteFlags()
     {
         $deadline = Grpc\Timeval::infFuture();
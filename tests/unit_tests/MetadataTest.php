@@ -0,0 +1,100 @@
+<?php
+/*
+ *
+ * Copyright 2015, Google Inc.
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ *     * Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ * copyright notice, this list of conditions and the following disclaimer
+ * in the documentation and/or other materials provided with the
+ * distribution.
+ *     * Neither the name of Google Inc. nor the names of its
+ * contributors may be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT
+ * OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+class MetadataTest extends PHPUnit_Framework_TestCase
+{
+    public function testNormalizeEmpty()
+    {
+        $this->assertSame([], Grpc\Metadata::normalize([]));
+    }
+
+    public function testNormalizeLowercasesKeys()
+    {
+        $metadata = Grpc\Metadata::normalize([
+            'Key-One' => ['a'],
+            'key_two.x' => ['b', 'c'],
+            'A-VERY-LONG-KEY-THAT-SPANS-MORE-THAN-SIXTEEN-BYTES' => ['d'],
+        ]);
+        $this->assertSame([
+            'key-one' => ['a'],
+            'key_two.x' => ['b', 'c'],
+            'a-very-long-key-that-spans-more-than-sixteen-bytes' => ['d'],
+        ], $metadata);
+    }
+
+    public function testNormalizeBinaryValue()
+    {
+        $metadata = Grpc\Metadata::normalize(['Key-Bin' => ["\x00\xff\n"]]);
+        $this->assertSame(['key-bin' => ["\x00\xff\n"]], $metadata);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNormalizeInvalidKey()
+    {
+        Grpc\Metadata::normalize(['a key' => ['value']]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNormalizeInvalidLongKey()
+    {
+        Grpc\Metadata::normalize(['abcdefghijklmnopqrstuvwxyz/' => ['value']]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNormalizeEmptyKey()
+    {
+        Grpc\Metadata::normalize(['' => ['value']]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNormalizeInvalidValue()
+    {
+        Grpc\Metadata::normalize(['key' => ["line\nbreak"]]);
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNormalizeValueNotArray()
+    {
+        Grpc\Metadata::normalize(['key' => 'value']);
+    }
+}
@@ -134,6 +134,75 @@ class TimevalTest extends PHPUnit_Framework_TestCase
         $this->assertTrue(($done_microtime - $curr_microtime) > 0.0009);
     }
 
+    public function testClockTypes()
+    {
+        $this->assertSame(Grpc\CLOCK_REALTIME,
+                          Grpc\Timeval::now()->getClockType());
+        $this->assertSame(Grpc\CLOCK_MONOTONIC,
+            Grpc\Timeval::now(Grpc\CLOCK_MONOTONIC)->getClockType());
+        $this->assertSame(Grpc\CLOCK_PRECISE,
+            Grpc\Timeval::now(Grpc\CLOCK_PRECISE)->getClockType());
+        $this->assertSame(Grpc\CLOCK_TIMESPAN,
+                          (new Grpc\Timeval(1000))->getClockType());
+    }
+
+    public function testMonotonicAddKeepsClockType()
+    {
+        $now = Grpc\Timeval::now(Grpc\CLOCK_MONOTONIC);
+        $delta = new Grpc\Timeval(1000);
+        $deadline = $now->add($delta);
+        $this->assertSame(Grpc\CLOCK_MONOTONIC, $deadline->getClockType());
+        $this->assertSame(Grpc\CLOCK_MONOTONIC,
+                          $delta->add($now)->getClockType());
+        $this->assertGreaterThan(0, Grpc\Timeval::compare($deadline, $now));
+        $elapsed = $deadline->subtract($now);
+        $this->assertSame(Grpc\CLOCK_TIMESPAN, $elapsed->getClockType());
+        $this->assertSame(0, Grpc\Timeval::compare($elapsed, $delta));
+    }
+
+    public function testCompareAcrossClocks()
+    {
+        $monotonic = Grpc\Timeval::now(Grpc\CLOCK_MONOTONIC);
+        $later = Grpc\Timeval::now()->add(new Grpc\Timeval(1000000));
+        $this->assertLessThan(0, Grpc\Timeval::compare($monotonic, $later));
+        $converted = $later->convert(Grpc\CLOCK_MONOTONIC);
+        $this->assertSame(Grpc\CLOCK_MONOTONIC, $converted->getClockType());
+    }
+
+    public function testConstantsAreShared()
+    {
+        $this->assertSame(Grpc\Timeval::zero(), Grpc\Timeval::zero());
+        $this->assertSame(Grpc\Timeval::infFuture(),
+                          Grpc\Timeval::infFuture());
+        $this->assertSame(Grpc\Timeval::infPast(), Grpc\Timeval::infPast());
+        $this->assertNotSame(Grpc\Timeval::infFuture(),
+                             Grpc\Timeval::infFuture(Grpc\CLOCK_MONOTONIC));
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testAddTwoPointsInTime()
+    {
+        Grpc\Timeval::now()->add(Grpc\Timeval::now());
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testCompareIntervalWithPointInTime()
+    {
+        Grpc\Timeval::compare(new Grpc\Timeval(1000), Grpc\Timeval::now());
+    }
+
+    /**
+     * @expectedException InvalidArgumentException
+     */
+    public function testNowInvalidClock()
+    {
+        Grpc\Timeval::now(Grpc\CLOCK_TIMESPAN);
+    }
+
     /**
      * @expectedException ErrorException 
      */
@@ -180,4 +249,22 @@ class TimevalTest extends PHPUnit_Framework_TestCase
         $this->setErrorHandler();
         $a = Grpc\Timeval::similar(1000, 1100, 1200);
     }
+
+    /**
+     * @expectedException LogicException
+     */
+    public function testSetPropertyOnSharedTimeval()
+    {
+        $zero = Grpc\Timeval::zero();
+        $zero->owner = 'caller';
+    }
+
+    public function testSharedTimevalHasNoProperties()
+    {
+        try {
+            Grpc\Timeval::infFuture()->owner = 'caller';
+        } catch (LogicException $e) {
+        }
+        $this->assertFalse(isset(Grpc\Timeval::infFuture()->owner));
+    }
 }